@@ -49,6 +49,109 @@
 
 #include "Inc/joystick.h"
 
+//------------------------------------------------------------------------------
+// SCHEDULER
+//------------------------------------------------------------------------------
+
+#include "Inc/scheduler.h"
+
+#include "Inc/logger.h"
+
+#include "Inc/benchmark.h"
+
+//=============================================================================
+//                                 TASKS
+//=============================================================================
+
+/**
+ * @brief Input task: determines the current joystick input mode and reads the joystick input.
+ */
+void inputTask() {
+
+  PROFILE_START(PROFILE_INPUT);
+
+#ifdef JOYSTICK_HARDWARE
+  // The hardware joystick takes over when no remote is connected, or when the remote has timed out
+  JOYSTICK_INPUT = BlueT.available() ? BLUETOOTH : (btLinkStats.linkActive ? NO_JOYSTICK : HARDWARE);
+#else
+  JOYSTICK_INPUT = BlueT.available() ? BLUETOOTH : NO_JOYSTICK;
+#endif
+
+#ifdef DEBUG_JOYSTICK
+  logEvent(LOG_INPUT_MODE, JOYSTICK_INPUT);
+#endif
+
+  readJoystick();
+
+  PROFILE_STOP(PROFILE_INPUT);
+}
+
+/**
+ * @brief Motor task: ramps the drive modes and speeds toward the targets computed from the last input, and applies them.
+ * @details Runs every MOTOR_CONTROL_PERIOD, also between input frames, so that the motors keep ramping smoothly.
+ */
+void motorTask() {
+  PROFILE_START(PROFILE_MOTORS);
+  updateMotorsRamp();
+  applyMotorsSettings();
+  PROFILE_SPAN_STOP(PROFILE_LATENCY);
+  PROFILE_STOP(PROFILE_MOTORS);
+}
+
+/**
+ * @brief LED task: updates the LED display.
+ */
+void ledTask() {
+  PROFILE_START(PROFILE_LED);
+  updateLED_Display();
+  PROFILE_STOP(PROFILE_LED);
+}
+
+/**
+ * @brief Buzzer task: queues the next notes of the music.
+ */
+void buzzerTask() {
+  PROFILE_START(PROFILE_BUZZER);
+  buzz();
+  PROFILE_STOP(PROFILE_BUZZER);
+}
+
+/**
+ * @brief Static task table of the scheduler: name, routine, period (µs) and budget (µs).
+ * @details The buzzer only refills the tone engine queue, which holds several notes, so it does not need a high rate.
+ */
+task_t tasks[] = {
+  TASK("input", inputTask, 5000, 1000),     // 200 Hz
+  TASK("motors", motorTask, MOTOR_CONTROL_PERIOD, 200),    // 100 Hz
+  TASK("LED", ledTask, 16667, 3000),        // 60 Hz
+  TASK("buzzer", buzzerTask, 20000, 300)    // 50 Hz
+};
+
+/**
+ * @brief Handles the requests received on the serial port when the CPU is idle.
+ * @details BT_STATS_REQUEST prints the Bluetooth link and LED frame statistics, PROFILE_DUMP_REQUEST the timing statistics (with PROFILE_TIMING).
+ */
+void readConsole() {
+  while (Serial.available()) {
+    switch (Serial.read()) {
+      case BT_STATS_REQUEST:
+        BT_printStats();
+        LED_printStats();
+        break;
+
+#ifdef PROFILE_TIMING
+      case PROFILE_DUMP_REQUEST:
+        profileDump();
+        schedulerPrintStats(tasks, TASK_COUNT(tasks));
+        break;
+#endif
+
+      default:
+        break;
+    }
+  }
+}
+
 //=============================================================================
 //                             SETUP PROCEDURE
 //=============================================================================
@@ -72,17 +175,23 @@
  *          - Switches off the motors.
  *          - Initializes the NeoPixel strip.
  *          - Calls the `updateLED_Display()` function to update the LED display.
+ *          - Starts the task scheduler.
  */
 void setup() {
 
   // Launch serial communication
   Serial.begin(SERIAL_RATE);
 
+#ifdef BENCHMARK_BT
+  benchmarkBT_process();
+#endif
+
   // Launch Bluetooth
   BlueT.begin(BT_RATE);
 
   // Buzzer configuration
   pinMode(BUZZER_PIN, OUTPUT);
+  toneEngineBegin();
 
   // Motor pins configuration
   pinMode(EN_A, OUTPUT);
@@ -91,9 +200,20 @@ void setup() {
   pinMode(IN_2, OUTPUT);
   pinMode(IN_3, OUTPUT);
   pinMode(IN_4, OUTPUT);
+  motorOutputBegin();
 
   // Harwdare joystick switch pin configuration
   pinMode(SW, INPUT_PULLUP);
+  joystickSwitchBegin();
+
+#ifdef JOYSTICK_HARDWARE
+  // Hardware joystick background acquisition
+  joystickAdcBegin();
+#endif
+
+#ifdef BENCHMARK_JOYSTICK
+  benchmarkDriveMixer();
+#endif
 
   // Initial motor states (switched off)
   resetMotorStates();
@@ -103,7 +223,18 @@ void setup() {
   pinMode(PIN_NEOPIXEL, OUTPUT);
   digitalWrite(PIN_NEOPIXEL, LOW);
   pixels.begin();
+
+#ifdef BENCHMARK_STRIP_LED
+  benchmarkLED_Display();
+#endif
+
+#ifdef BENCHMARK_CYCLES
+  benchmarkCycles();
+#endif
+
   updateLED_Display();
+
+  schedulerBegin(tasks, TASK_COUNT(tasks));
 }
 
 //=============================================================================
@@ -113,25 +244,19 @@ void setup() {
 
 /**
  * @brief The main loop of the Arduino Mega program.
- * @details This function is called repeatedly after the `setup()` function. It performs the following tasks:
- *          - Determines the current joystick input mode ('Bluetooth' or 'no joystick').
- *          - Reads the joystick input.
+ * @details This function is called repeatedly after the `setup()` function. It runs the scheduler, which performs the following tasks at a fixed rate:
+ *          - Determines the current joystick input mode ('Bluetooth' or 'no joystick') and reads the joystick input.
+ *          - Applies the motor settings.
  *          - Updates the LED display.
  *          - Play buzzer music.
+ *          When no task is ready, the serial requests are handled, the buffered log records are sent and the CPU idles.
  */
 void loop() {
+  PROFILE_PERIOD(PROFILE_LOOP);
 
-  JOYSTICK_INPUT = BlueT.available() ? BLUETOOTH : NO_JOYSTICK;
-
-  // delay(200); // to make serial output more readable and chill the motors if needed
-
-#ifdef DEBUG_JOYSTICK
-  debug.printf("Input mode: %s\n", getJoystickInputName());
-#endif
-
-  readJoystick();
-
-  updateLED_Display();
-
-  buzz();
+  if (!schedulerRun(tasks, TASK_COUNT(tasks))) {
+    readConsole();
+    logDrain();
+    schedulerIdle();
+  }
 }
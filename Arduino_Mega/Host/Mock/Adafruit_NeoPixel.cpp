@@ -0,0 +1,230 @@
+/**
+* @file Adafruit_NeoPixel.cpp
+* @brief Adafruit_NeoPixel library of the host simulation.
+* @details The pixel buffer handling follows the library; only the bit-banging of show() is replaced by hostStripReceive().
+*/
+
+//=============================================================================
+//                       INCLUDE LIBRARIES AND HEADER FILES
+//=============================================================================
+
+#include "host.h"
+
+#include <Adafruit_NeoPixel.h>
+
+//=============================================================================
+//                                   MACROS
+//=============================================================================
+
+/**
+ * @brief Time the data line must stay low before a new frame can be sent (µs), as in the library.
+ */
+#define NEOPIXEL_LATCH_TIME 300
+
+//=============================================================================
+//                              CLASS DEFINITIONS
+//=============================================================================
+
+Adafruit_NeoPixel::Adafruit_NeoPixel(uint16_t n, int16_t p, neoPixelType t)
+    : begun(false), brightness(0), pixels(NULL), endTime(0) {
+    updateType(t);
+    updateLength(n);
+    setPin(p);
+}
+
+Adafruit_NeoPixel::Adafruit_NeoPixel()
+    : is800KHz(true), begun(false), numLEDs(0), numBytes(0), pin(-1), brightness(0), pixels(NULL),
+      rOffset(1), gOffset(0), bOffset(2), wOffset(1), endTime(0) {
+}
+
+Adafruit_NeoPixel::~Adafruit_NeoPixel() {
+    free(pixels);
+}
+
+void Adafruit_NeoPixel::begin() {
+    if (pin >= 0) {
+        pinMode(pin, OUTPUT);
+        digitalWrite(pin, LOW);
+    }
+    hostStripBegin(numBytes);
+    begun = true;
+}
+
+void Adafruit_NeoPixel::updateLength(uint16_t n) {
+    free(pixels);
+
+    numBytes = n * ((wOffset == rOffset) ? 3 : 4);
+    if ((pixels = (uint8_t*)malloc(numBytes))) {
+        memset(pixels, 0, numBytes);
+        numLEDs = n;
+    } else {
+        numLEDs = numBytes = 0;
+    }
+}
+
+void Adafruit_NeoPixel::updateType(neoPixelType t) {
+    bool oldThreeBytesPerPixel = (wOffset == rOffset);
+
+    wOffset = (t >> 6) & 0b11;
+    rOffset = (t >> 4) & 0b11;
+    gOffset = (t >> 2) & 0b11;
+    bOffset = t & 0b11;
+    is800KHz = (t < 256);
+
+    // The buffer must be resized if the number of bytes per pixel changes
+    if (pixels) {
+        bool newThreeBytesPerPixel = (wOffset == rOffset);
+        if (newThreeBytesPerPixel != oldThreeBytesPerPixel) {
+            updateLength(numLEDs);
+        }
+    }
+}
+
+void Adafruit_NeoPixel::setPin(int16_t p) {
+    if (begun && pin >= 0) {
+        pinMode(pin, INPUT);
+    }
+    pin = p;
+    if (begun) {
+        pinMode(p, OUTPUT);
+        digitalWrite(p, LOW);
+    }
+}
+
+bool Adafruit_NeoPixel::canShow() {
+    uint32_t now = micros();
+
+    // micros() wrapped around
+    if (endTime > now) {
+        endTime = now;
+    }
+    return (now - endTime) >= NEOPIXEL_LATCH_TIME;
+}
+
+/**
+ * @brief Sends the pixel buffer to the strip with the interrupts disabled, after the latch time of the previous frame.
+ */
+void Adafruit_NeoPixel::show() {
+    HostCall call;
+
+    if (!pixels) {
+        return;
+    }
+
+    // The library spins on canShow(), which is where the virtual time advances
+    while (!canShow()) {
+        hostAdvance(NEOPIXEL_LATCH_TIME - (micros() - endTime));
+    }
+
+    noInterrupts();
+    hostStripReceive(pixels, numBytes);
+    interrupts();
+
+    endTime = micros();
+}
+
+void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b) {
+    if (n < numLEDs) {
+        if (brightness) {
+            r = (r * brightness) >> 8;
+            g = (g * brightness) >> 8;
+            b = (b * brightness) >> 8;
+        }
+
+        uint8_t* p;
+        if (wOffset == rOffset) {
+            p = &pixels[n * 3];
+        } else {
+            p = &pixels[n * 4];
+            p[wOffset] = 0;
+        }
+        p[rOffset] = r;
+        p[gOffset] = g;
+        p[bOffset] = b;
+    }
+}
+
+void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b, uint8_t w) {
+    if (n < numLEDs) {
+        if (brightness) {
+            r = (r * brightness) >> 8;
+            g = (g * brightness) >> 8;
+            b = (b * brightness) >> 8;
+            w = (w * brightness) >> 8;
+        }
+
+        uint8_t* p;
+        if (wOffset == rOffset) {
+            p = &pixels[n * 3];
+        } else {
+            p = &pixels[n * 4];
+            p[wOffset] = w;
+        }
+        p[rOffset] = r;
+        p[gOffset] = g;
+        p[bOffset] = b;
+    }
+}
+
+void Adafruit_NeoPixel::setPixelColor(uint16_t n, uint32_t c) {
+    setPixelColor(n, (uint8_t)(c >> 16), (uint8_t)(c >> 8), (uint8_t)c, (uint8_t)(c >> 24));
+}
+
+void Adafruit_NeoPixel::fill(uint32_t c, uint16_t first, uint16_t count) {
+    if (first >= numLEDs) {
+        return;
+    }
+
+    uint16_t end = (count == 0) ? numLEDs : min((uint32_t)first + count, (uint32_t)numLEDs);
+
+    for (uint16_t i = first; i < end; i++) {
+        setPixelColor(i, c);
+    }
+}
+
+/**
+ * @brief Sets the brightness of the next colors, and rescales the colors already in the buffer (lossy).
+ */
+void Adafruit_NeoPixel::setBrightness(uint8_t b) {
+    // Stored as b + 1: 0 is the full brightness without scaling, 1 is off
+    uint8_t newBrightness = b + 1;
+
+    if (newBrightness != brightness) {
+        uint8_t oldBrightness = brightness - 1;
+        uint16_t scale;
+
+        if (oldBrightness == 0) {
+            scale = 0;
+        } else if (b == 255) {
+            scale = 65535 / oldBrightness;
+        } else {
+            scale = (((uint16_t)newBrightness << 8) - 1) / oldBrightness;
+        }
+
+        for (uint16_t i = 0; i < numBytes; i++) {
+            pixels[i] = (pixels[i] * scale) >> 8;
+        }
+        brightness = newBrightness;
+    }
+}
+
+void Adafruit_NeoPixel::clear() {
+    memset(pixels, 0, numBytes);
+}
+
+uint32_t Adafruit_NeoPixel::getPixelColor(uint16_t n) const {
+    if (n >= numLEDs) {
+        return 0;
+    }
+
+    const uint8_t* p = (wOffset == rOffset) ? &pixels[n * 3] : &pixels[n * 4];
+    uint32_t w = (wOffset == rOffset) ? 0 : p[wOffset];
+
+    if (brightness) {
+        // Stored colors were scaled down by the brightness: scale them back up, approximately
+        return (((w << 8) / brightness) << 24) | (((uint32_t)(p[rOffset] << 8) / brightness) << 16)
+               | (((uint32_t)(p[gOffset] << 8) / brightness) << 8) | ((uint32_t)(p[bOffset] << 8) / brightness);
+    }
+
+    return (w << 24) | ((uint32_t)p[rOffset] << 16) | ((uint32_t)p[gOffset] << 8) | p[bOffset];
+}
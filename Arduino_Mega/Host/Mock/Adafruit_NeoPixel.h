@@ -0,0 +1,89 @@
+/**
+* @file Adafruit_NeoPixel.h
+* @brief Adafruit_NeoPixel library of the host simulation.
+* @details Same interface and pixel buffer handling as the library (color order, brightness scaling, protected members used
+*          by derived drivers). show() waits for the 300 µs latch time, then sends the buffer to the simulated strip with
+*          the interrupts disabled, 10 µs per byte, as the AVR implementation does.
+*/
+
+#pragma once
+
+//=============================================================================
+//                       INCLUDE LIBRARIES AND HEADER FILES
+//=============================================================================
+
+#include <Arduino.h>
+
+//=============================================================================
+//                              TYPE DECLARATIONS
+//=============================================================================
+
+typedef uint16_t neoPixelType;
+
+//=============================================================================
+//                                   MACROS
+//=============================================================================
+
+// Offsets of the white, red, green and blue bytes of a pixel, packed in 2 bits each
+#define NEO_RGB ((0 << 6) | (0 << 4) | (1 << 2) | (2))
+#define NEO_RBG ((0 << 6) | (0 << 4) | (2 << 2) | (1))
+#define NEO_GRB ((1 << 6) | (1 << 4) | (0 << 2) | (2))
+#define NEO_GBR ((2 << 6) | (2 << 4) | (0 << 2) | (1))
+#define NEO_BRG ((1 << 6) | (1 << 4) | (2 << 2) | (0))
+#define NEO_BGR ((2 << 6) | (2 << 4) | (1 << 2) | (0))
+#define NEO_GRBW ((3 << 6) | (1 << 4) | (0 << 2) | (2))
+
+#define NEO_KHZ800 0x0000
+#define NEO_KHZ400 0x0100
+
+//=============================================================================
+//                              CLASS DECLARATIONS
+//=============================================================================
+
+class Adafruit_NeoPixel {
+    public:
+        Adafruit_NeoPixel(uint16_t n, int16_t pin = 6, neoPixelType type = NEO_GRB + NEO_KHZ800);
+        Adafruit_NeoPixel();
+        ~Adafruit_NeoPixel();
+
+        void begin();
+        void show();
+        void setPin(int16_t p);
+        void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b);
+        void setPixelColor(uint16_t n, uint8_t r, uint8_t g, uint8_t b, uint8_t w);
+        void setPixelColor(uint16_t n, uint32_t c);
+        void fill(uint32_t c = 0, uint16_t first = 0, uint16_t count = 0);
+        void setBrightness(uint8_t b);
+        void clear();
+        void updateLength(uint16_t n);
+        void updateType(neoPixelType t);
+
+        bool canShow();
+        uint8_t* getPixels() const { return pixels; }
+        uint8_t getBrightness() const { return brightness - 1; }
+        int16_t getPin() const { return pin; }
+        uint16_t numPixels() const { return numLEDs; }
+        uint32_t getPixelColor(uint16_t n) const;
+
+        static uint32_t Color(uint8_t r, uint8_t g, uint8_t b) {
+            return ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+        }
+
+        static uint32_t Color(uint8_t r, uint8_t g, uint8_t b, uint8_t w) {
+            return ((uint32_t)w << 24) | ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+        }
+
+    protected:
+        bool is800KHz;          /**< true if 800 KHz pixels */
+        bool begun;             /**< true if begin() previously called */
+        uint16_t numLEDs;       /**< Number of RGB LEDs in strip */
+        uint16_t numBytes;      /**< Size of 'pixels' buffer below */
+        int16_t pin;            /**< Output pin number (-1 if not yet set) */
+        uint8_t brightness;     /**< Strip brightness 0-255 (stored as +1) */
+        uint8_t* pixels;        /**< Holds LED color values (3 or 4 bytes each) */
+        uint8_t rOffset;        /**< Red index within each 3- or 4-byte pixel */
+        uint8_t gOffset;        /**< Index of green byte */
+        uint8_t bOffset;        /**< Index of blue byte */
+        uint8_t wOffset;        /**< Index of white (== rOffset if no white) */
+        uint32_t endTime;       /**< Latch timing reference */
+};
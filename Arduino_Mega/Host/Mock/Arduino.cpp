@@ -0,0 +1,387 @@
+/**
+* @file Arduino.cpp
+* @brief Arduino core API of the host simulation, on top of the simulated registers.
+* @details The pins are mapped to the ports of the ATmega2560 as on the Arduino Mega 2560, so digitalWrite() and a direct
+*          PORTx write of the firmware act on the same simulated pin.
+*/
+
+//=============================================================================
+//                       INCLUDE LIBRARIES AND HEADER FILES
+//=============================================================================
+
+#include "host.h"
+
+#include <Arduino.h>
+
+//=============================================================================
+//                             VARIABLE DEFINITIONS
+//=============================================================================
+
+/**
+ * @brief Port of each pin of the Arduino Mega 2560.
+ */
+static const uint8_t pinPorts[NUM_DIGITAL_PINS] = {
+    PE, PE, PE, PE, PG, PE, PH, PH, PH, PH,     // 0 to 9
+    PB, PB, PB, PB, PJ, PJ, PH, PH, PD, PD,     // 10 to 19
+    PD, PD, PA, PA, PA, PA, PA, PA, PA, PA,     // 20 to 29
+    PC, PC, PC, PC, PC, PC, PC, PC, PD, PG,     // 30 to 39
+    PG, PG, PL, PL, PL, PL, PL, PL, PL, PL,     // 40 to 49
+    PB, PB, PB, PB, PF, PF, PF, PF, PF, PF,     // 50 to 59
+    PF, PF, PK, PK, PK, PK, PK, PK, PK, PK      // 60 to 69
+};
+
+/**
+ * @brief Bit of each pin of the Arduino Mega 2560 in its port.
+ */
+static const uint8_t pinBits[NUM_DIGITAL_PINS] = {
+    0, 1, 4, 5, 5, 3, 3, 4, 5, 6,
+    4, 5, 6, 7, 1, 0, 1, 0, 3, 2,
+    1, 0, 0, 1, 2, 3, 4, 5, 6, 7,
+    7, 6, 5, 4, 3, 2, 1, 0, 7, 2,
+    1, 0, 7, 6, 5, 4, 3, 2, 1, 0,
+    3, 2, 1, 0, 0, 1, 2, 3, 4, 5,
+    6, 7, 0, 1, 2, 3, 4, 5, 6, 7
+};
+
+static HostRegister8* const outputRegisters[] = { NULL, &PORTA, &PORTB, &PORTC, &PORTD, &PORTE, &PORTF, &PORTG, &PORTH, NULL, &PORTJ, &PORTK, &PORTL };
+static HostRegister8* const inputRegisters[] = { NULL, &PINA, &PINB, &PINC, &PIND, &PINE, &PINF, &PING, &PINH, NULL, &PINJ, &PINK, &PINL };
+static HostRegister8* const modeRegisters[] = { NULL, &DDRA, &DDRB, &DDRC, &DDRD, &DDRE, &DDRF, &DDRG, &DDRH, NULL, &DDRJ, &DDRK, &DDRL };
+
+/**
+ * @brief Last value given to analogWrite() and frequency played by tone() for each pin.
+ */
+static int analogOutputs[NUM_DIGITAL_PINS];
+static unsigned int toneFrequencies[NUM_DIGITAL_PINS];
+
+//=============================================================================
+//                              ROUTINE DEFINITIONS
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+// Pins
+//-----------------------------------------------------------------------------
+
+uint8_t digitalPinToPort(uint8_t pin) {
+    return pin < NUM_DIGITAL_PINS ? pinPorts[pin] : NOT_A_PIN;
+}
+
+uint8_t digitalPinToBitMask(uint8_t pin) {
+    return pin < NUM_DIGITAL_PINS ? _BV(pinBits[pin]) : 0;
+}
+
+HostRegister8* portOutputRegister(uint8_t port) {
+    return port <= PL ? outputRegisters[port] : NULL;
+}
+
+HostRegister8* portInputRegister(uint8_t port) {
+    return port <= PL ? inputRegisters[port] : NULL;
+}
+
+HostRegister8* portModeRegister(uint8_t port) {
+    return port <= PL ? modeRegisters[port] : NULL;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    uint8_t port = digitalPinToPort(pin);
+    uint8_t mask = digitalPinToBitMask(pin);
+
+    if (port == NOT_A_PIN) {
+        return;
+    }
+
+    uint8_t oldSREG = SREG;
+    cli();
+
+    if (mode == OUTPUT) {
+        *portModeRegister(port) |= mask;
+    } else {
+        *portModeRegister(port) &= ~mask;
+
+        if (mode == INPUT_PULLUP) {
+            *portOutputRegister(port) |= mask;
+        } else {
+            *portOutputRegister(port) &= ~mask;
+        }
+    }
+
+    SREG = oldSREG;
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+    uint8_t port = digitalPinToPort(pin);
+    uint8_t mask = digitalPinToBitMask(pin);
+
+    if (port == NOT_A_PIN) {
+        return;
+    }
+
+    uint8_t oldSREG = SREG;
+    cli();
+
+    if (value == LOW) {
+        *portOutputRegister(port) &= ~mask;
+    } else {
+        *portOutputRegister(port) |= mask;
+    }
+
+    SREG = oldSREG;
+}
+
+int digitalRead(uint8_t pin) {
+    uint8_t port = digitalPinToPort(pin);
+
+    if (port == NOT_A_PIN) {
+        return LOW;
+    }
+
+    return (*portInputRegister(port) & digitalPinToBitMask(pin)) ? HIGH : LOW;
+}
+
+/**
+ * @brief Converts an analog input with the ADC, waiting for the end of the conversion (about 104 µs).
+ * @param pin Analog pin (A0 to A15) or channel number (0 to 15).
+ */
+int analogRead(uint8_t pin) {
+    HostCall call;
+    uint8_t channel = (pin >= A0) ? pin - A0 : pin;
+
+    ADCSRB = (ADCSRB & ~_BV(MUX5)) | ((channel & 0x08) ? _BV(MUX5) : 0);
+    ADMUX = _BV(REFS0) | (channel & 0x07);
+    ADCSRA |= _BV(ADEN) | _BV(ADSC);
+
+    while (bit_is_set(ADCSRA, ADSC)) {
+        hostAdvance(1);
+    }
+
+    return ADC;
+}
+
+/**
+ * @brief Records the duty cycle of a PWM output, 0 and 255 set the pin as digitalWrite() does.
+ */
+void analogWrite(uint8_t pin, int value) {
+    HostCall call;
+
+    pinMode(pin, OUTPUT);
+
+    if (pin < NUM_DIGITAL_PINS) {
+        analogOutputs[pin] = value;
+    }
+
+    if (value <= 0) {
+        digitalWrite(pin, LOW);
+    } else if (value >= 255) {
+        digitalWrite(pin, HIGH);
+    }
+}
+
+int hostAnalogOutput(uint8_t pin) {
+    return pin < NUM_DIGITAL_PINS ? analogOutputs[pin] : 0;
+}
+
+/**
+ * @brief Records the frequency played on a pin. The duration is ignored: the tone lasts until noTone().
+ */
+void tone(uint8_t pin, unsigned int frequency, unsigned long) {
+    HostCall call;
+
+    if (pin < NUM_DIGITAL_PINS) {
+        pinMode(pin, OUTPUT);
+        toneFrequencies[pin] = frequency;
+    }
+}
+
+void noTone(uint8_t pin) {
+    HostCall call;
+
+    if (pin < NUM_DIGITAL_PINS) {
+        toneFrequencies[pin] = 0;
+        digitalWrite(pin, LOW);
+    }
+}
+
+unsigned int hostToneFrequency(uint8_t pin) {
+    return pin < NUM_DIGITAL_PINS ? toneFrequencies[pin] : 0;
+}
+
+//-----------------------------------------------------------------------------
+// Time
+//-----------------------------------------------------------------------------
+
+unsigned long millis() {
+    HostCall call;
+    return hostTime() / 1000000;
+}
+
+unsigned long micros() {
+    HostCall call;
+    return hostTime() / 1000;
+}
+
+void delay(unsigned long ms) {
+    HostCall call;
+    hostAdvance(1000 * ms);
+}
+
+void delayMicroseconds(unsigned int us) {
+    HostCall call;
+    hostAdvance(us);
+}
+
+//-----------------------------------------------------------------------------
+// Number conversions
+//-----------------------------------------------------------------------------
+
+char* ultoa(unsigned long value, char* string, int base) {
+    char digits[8 * sizeof(value) + 1];
+    uint8_t length = 0;
+
+    do {
+        uint8_t digit = value % base;
+        digits[length++] = digit < 10 ? '0' + digit : 'a' + digit - 10;
+        value /= base;
+    } while (value != 0);
+
+    for (uint8_t i = 0; i < length; i++) {
+        string[i] = digits[length - 1 - i];
+    }
+    string[length] = '\0';
+
+    return string;
+}
+
+char* ltoa(long value, char* string, int base) {
+    if (value < 0 && base == 10) {
+        string[0] = '-';
+        ultoa(-(unsigned long)value, string + 1, base);
+        return string;
+    }
+
+    return ultoa(value, string, base);
+}
+
+char* utoa(unsigned int value, char* string, int base) {
+    return ultoa(value, string, base);
+}
+
+char* itoa(int value, char* string, int base) {
+    // As avr-libc: negative values are only signed in base 10, otherwise they are printed as 16-bit unsigned values
+    return (base == 10) ? ltoa(value, string, base) : ultoa((uint16_t)value, string, base);
+}
+
+//-----------------------------------------------------------------------------
+// Print
+//-----------------------------------------------------------------------------
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t written = 0;
+
+    while (size--) {
+        if (!write(*buffer++)) {
+            break;
+        }
+        written++;
+    }
+
+    return written;
+}
+
+size_t Print::printNumber(unsigned long number, uint8_t base) {
+    char buffer[8 * sizeof(number) + 1];
+    return write(ultoa(number, buffer, base < 2 ? 10 : base));
+}
+
+size_t Print::printFloat(double number, uint8_t digits) {
+    char buffer[48];
+
+    if (isnan(number)) {
+        return print("nan");
+    }
+    if (isinf(number)) {
+        return print("inf");
+    }
+
+    snprintf(buffer, sizeof(buffer), "%.*f", digits, number);
+    return print(buffer);
+}
+
+size_t Print::print(const __FlashStringHelper* string) {
+    return write((const char*)string);
+}
+
+size_t Print::print(const char* string) {
+    return write(string);
+}
+
+size_t Print::print(char character) {
+    return write((uint8_t)character);
+}
+
+size_t Print::print(unsigned char number, int base) {
+    return print((unsigned long)number, base);
+}
+
+size_t Print::print(int number, int base) {
+    return print((long)number, base);
+}
+
+size_t Print::print(unsigned int number, int base) {
+    return print((unsigned long)number, base);
+}
+
+size_t Print::print(long number, int base) {
+    if (base == 10 && number < 0) {
+        return print('-') + printNumber(-(unsigned long)number, 10);
+    }
+
+    // As the Arduino core: negative numbers are printed as unsigned in the other bases
+    return printNumber((unsigned long)number, base);
+}
+
+size_t Print::print(unsigned long number, int base) {
+    return printNumber(number, base);
+}
+
+size_t Print::print(double number, int digits) {
+    return printFloat(number, digits);
+}
+
+size_t Print::println() {
+    return write("\r\n");
+}
+
+size_t Print::println(const __FlashStringHelper* string) {
+    return print(string) + println();
+}
+
+size_t Print::println(const char* string) {
+    return print(string) + println();
+}
+
+size_t Print::println(char character) {
+    return print(character) + println();
+}
+
+size_t Print::println(unsigned char number, int base) {
+    return print(number, base) + println();
+}
+
+size_t Print::println(int number, int base) {
+    return print(number, base) + println();
+}
+
+size_t Print::println(unsigned int number, int base) {
+    return print(number, base) + println();
+}
+
+size_t Print::println(long number, int base) {
+    return print(number, base) + println();
+}
+
+size_t Print::println(unsigned long number, int base) {
+    return print(number, base) + println();
+}
+
+size_t Print::println(double number, int digits) {
+    return print(number, digits) + println();
+}
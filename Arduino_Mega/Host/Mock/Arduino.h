@@ -0,0 +1,231 @@
+/**
+* @file Arduino.h
+* @brief Arduino core API of the host simulation.
+* @details Mirrors the parts of the Arduino AVR core used by the firmware and its libraries: time, digital and analog pins,
+*          tone, Print, Stream and the USB serial port. Time is virtual: it advances when the firmware waits (delay(),
+*          sleep, serial transmission, LED strip transmission), by the execution time of the firmware, or when the
+*          simulation is told to, see host.h.
+*/
+
+#pragma once
+
+//=============================================================================
+//                       INCLUDE LIBRARIES AND HEADER FILES
+//=============================================================================
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+//=============================================================================
+//                              TYPE DECLARATIONS
+//=============================================================================
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+/**
+ * @brief String stored in flash, see F().
+ */
+class __FlashStringHelper;
+
+//=============================================================================
+//                                   MACROS
+//=============================================================================
+
+#define F_CPU 16000000UL
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define A0 54
+#define A1 55
+#define A2 56
+#define A3 57
+#define A4 58
+#define A5 59
+#define A6 60
+#define A7 61
+
+#define NUM_DIGITAL_PINS 70
+
+#define NOT_A_PIN 0
+#define PA 1
+#define PB 2
+#define PC 3
+#define PD 4
+#define PE 5
+#define PF 6
+#define PG 7
+#define PH 8
+#define PJ 10
+#define PK 11
+#define PL 12
+
+#define SERIAL_8N1 0x06
+
+#define F(string) (reinterpret_cast<const __FlashStringHelper*>(PSTR(string)))
+
+#define interrupts() sei()
+#define noInterrupts() cli()
+
+#define clockCyclesPerMicrosecond() (F_CPU / 1000000L)
+
+#define min(a, b) ((a) < (b) ? (a) : (b))
+#define max(a, b) ((a) > (b) ? (a) : (b))
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+#define lowByte(w) ((uint8_t)((w) & 0xff))
+#define highByte(w) ((uint8_t)((w) >> 8))
+
+#define bitRead(value, bit) (((value) >> (bit)) & 0x01)
+#define bitSet(value, bit) ((value) |= (1UL << (bit)))
+#define bitClear(value, bit) ((value) &= ~(1UL << (bit)))
+
+//=============================================================================
+//                              CLASS DECLARATIONS
+//=============================================================================
+
+/**
+ * @brief Base class of the character outputs, as in the Arduino core.
+ */
+class Print {
+    public:
+        virtual ~Print() {}
+
+        virtual size_t write(uint8_t byte) = 0;
+        virtual size_t write(const uint8_t* buffer, size_t size);
+        size_t write(const char* string) { return string ? write((const uint8_t*)string, strlen(string)) : 0; }
+        size_t write(const char* buffer, size_t size) { return write((const uint8_t*)buffer, size); }
+
+        virtual int availableForWrite() { return 0; }
+        virtual void flush() {}
+
+        size_t print(const __FlashStringHelper* string);
+        size_t print(const char* string);
+        size_t print(char character);
+        size_t print(unsigned char number, int base = DEC);
+        size_t print(int number, int base = DEC);
+        size_t print(unsigned int number, int base = DEC);
+        size_t print(long number, int base = DEC);
+        size_t print(unsigned long number, int base = DEC);
+        size_t print(double number, int digits = 2);
+
+        size_t println(const __FlashStringHelper* string);
+        size_t println(const char* string);
+        size_t println(char character);
+        size_t println(unsigned char number, int base = DEC);
+        size_t println(int number, int base = DEC);
+        size_t println(unsigned int number, int base = DEC);
+        size_t println(long number, int base = DEC);
+        size_t println(unsigned long number, int base = DEC);
+        size_t println(double number, int digits = 2);
+        size_t println();
+
+    private:
+        size_t printNumber(unsigned long number, uint8_t base);
+        size_t printFloat(double number, uint8_t digits);
+};
+
+/**
+ * @brief Base class of the character inputs, as in the Arduino core.
+ */
+class Stream : public Print {
+    public:
+        virtual int available() = 0;
+        virtual int read() = 0;
+        virtual int peek() = 0;
+
+        void setTimeout(unsigned long timeout) { this->timeout = timeout; }
+        unsigned long getTimeout() { return timeout; }
+
+    protected:
+        unsigned long timeout = 1000;
+};
+
+/**
+ * @brief USB serial port (USART0).
+ * @details Received characters are given by the simulation with hostSerialReceive(). Sent characters are written to the
+ *          standard output of the simulation as they are, so that it can be piped to the tools of the robot, and are sent
+ *          at the configured baud rate through a SERIAL_TX_BUFFER_SIZE bytes buffer: writing to a full buffer waits.
+ */
+class HardwareSerial : public Stream {
+    public:
+        void begin(unsigned long baud, uint8_t config = SERIAL_8N1);
+        void end();
+
+        int available();
+        int read();
+        int peek();
+        int availableForWrite();
+        void flush();
+        size_t write(uint8_t byte);
+        using Print::write;
+
+        operator bool() { return true; }
+};
+
+//=============================================================================
+//                              VARIABLE DECLARATIONS
+//=============================================================================
+
+extern HardwareSerial Serial;
+
+//=============================================================================
+//                           ROUTINE PROTOTYPES
+//=============================================================================
+
+extern void init();
+
+extern uint8_t digitalPinToPort(uint8_t pin);
+extern uint8_t digitalPinToBitMask(uint8_t pin);
+extern HostRegister8* portOutputRegister(uint8_t port);
+extern HostRegister8* portInputRegister(uint8_t port);
+extern HostRegister8* portModeRegister(uint8_t port);
+
+extern unsigned long millis();
+extern unsigned long micros();
+extern void delay(unsigned long ms);
+extern void delayMicroseconds(unsigned int us);
+
+extern void pinMode(uint8_t pin, uint8_t mode);
+extern void digitalWrite(uint8_t pin, uint8_t value);
+extern int digitalRead(uint8_t pin);
+
+extern int analogRead(uint8_t pin);
+extern void analogWrite(uint8_t pin, int value);
+
+extern void tone(uint8_t pin, unsigned int frequency, unsigned long duration = 0);
+extern void noTone(uint8_t pin);
+
+extern char* itoa(int value, char* string, int base);
+extern char* ltoa(long value, char* string, int base);
+extern char* utoa(unsigned int value, char* string, int base);
+extern char* ultoa(unsigned long value, char* string, int base);
+
+inline bool isDigit(int c) { return c >= '0' && c <= '9'; }
+inline bool isAlpha(int c) { return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'); }
+inline bool isSpace(int c) { return c == ' ' || (c >= '\t' && c <= '\r'); }
+
+//=============================================================================
+//                           SKETCH ROUTINES
+//=============================================================================
+
+extern void setup();
+extern void loop();
@@ -0,0 +1,40 @@
+/**
+* @file Bonezegei_Printf.h
+* @brief Bonezegei_Printf library of the host simulation: printf() on a serial port.
+*/
+
+#pragma once
+
+//=============================================================================
+//                       INCLUDE LIBRARIES AND HEADER FILES
+//=============================================================================
+
+#include <stdarg.h>
+
+#include <Arduino.h>
+
+//=============================================================================
+//                              CLASS DECLARATIONS
+//=============================================================================
+
+/**
+ * @brief Formats text with vsnprintf() and prints it on a serial port.
+ */
+class Bonezegei_Printf {
+    public:
+        explicit Bonezegei_Printf(HardwareSerial* serial) : serial(serial) {}
+
+        void printf(const char* format, ...) {
+            char buffer[128];
+            va_list arguments;
+
+            va_start(arguments, format);
+            vsnprintf(buffer, sizeof(buffer), format, arguments);
+            va_end(arguments);
+
+            serial->print(buffer);
+        }
+
+    private:
+        HardwareSerial* serial;
+};
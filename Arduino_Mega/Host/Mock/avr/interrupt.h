@@ -0,0 +1,55 @@
+/**
+* @file interrupt.h
+* @brief Interrupt handling of the host simulation.
+* @details An interrupt service routine is a plain C function named after its vector, called by the simulation when
+*          its interrupt is pending and enabled while the I flag of SREG is set, see hostServiceInterrupts().
+*/
+
+#pragma once
+
+//=============================================================================
+//                       INCLUDE LIBRARIES AND HEADER FILES
+//=============================================================================
+
+#include <avr/io.h>
+
+//=============================================================================
+//                                   MACROS
+//=============================================================================
+
+/**
+ * @brief Defines the interrupt service routine of a vector.
+ */
+#define ISR(vector, ...) extern "C" void vector(void); extern "C" void vector(void)
+
+/**
+ * @brief Enables the interrupts: the pending ones are serviced right away.
+ */
+#define sei() (SREG |= _BV(SREG_I))
+
+/**
+ * @brief Disables the interrupts.
+ */
+#define cli() (SREG &= (uint8_t)~_BV(SREG_I))
+
+//=============================================================================
+//                           ROUTINE PROTOTYPES
+//=============================================================================
+
+/**
+ * @brief Interrupt vectors serviced by the simulation, in decreasing priority order.
+ */
+extern "C" {
+void INT0_vect(void);
+void INT1_vect(void);
+void INT2_vect(void);
+void INT3_vect(void);
+void INT4_vect(void);
+void INT5_vect(void);
+void INT6_vect(void);
+void INT7_vect(void);
+void TIMER1_COMPA_vect(void);
+void ADC_vect(void);
+void USART1_RX_vect(void);
+void TIMER5_OVF_vect(void);
+}
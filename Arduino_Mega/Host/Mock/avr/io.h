@@ -0,0 +1,326 @@
+/**
+* @file io.h
+* @brief ATmega2560 registers and bit names of the host simulation.
+* @details Each register is an object: plain registers just hold their value, the registers of the simulated peripherals
+*          (status register, ports, Timer1, Timer5, ADC, USART1, external interrupts) call the simulation on each access,
+*          see host.cpp. Only the registers and bits used by the firmware are declared.
+*/
+
+#pragma once
+
+//=============================================================================
+//                       INCLUDE LIBRARIES AND HEADER FILES
+//=============================================================================
+
+#include <stdint.h>
+
+//=============================================================================
+//                              CLASS DECLARATIONS
+//=============================================================================
+
+/**
+ * @brief 8-bit I/O register.
+ * @details Reads and writes go through the optional hooks of the register, so that a peripheral can update its state
+ *          (e.g. reading UDR1 pops the receive FIFO). Read-modify-write operators are made of a read and a write, as on the AVR.
+ */
+class HostRegister8 {
+    public:
+        typedef uint8_t (*readHook_t)(const HostRegister8& reg);
+        typedef void (*writeHook_t)(HostRegister8& reg, uint8_t value);
+
+        /**
+         * @brief Creates a register.
+         * @param id Identifier passed to the hooks through the register, e.g. the index of a port.
+         * @param onRead Hook returning the value read, NULL to read the stored value.
+         * @param onWrite Hook storing the value written, NULL to store it as is.
+         */
+        explicit HostRegister8(uint8_t id = 0, readHook_t onRead = nullptr, writeHook_t onWrite = nullptr)
+            : value(0), id(id), onRead(onRead), onWrite(onWrite) {}
+
+        HostRegister8(const HostRegister8&) = delete;
+
+        operator uint8_t() const { return onRead ? onRead(*this) : value; }
+
+        HostRegister8& operator=(uint8_t newValue) {
+            if (onWrite) {
+                onWrite(*this, newValue);
+            } else {
+                value = newValue;
+            }
+            return *this;
+        }
+
+        HostRegister8& operator=(const HostRegister8& other) { return *this = (uint8_t)other; }
+        HostRegister8& operator|=(uint8_t bits) { return *this = (uint8_t)(*this | bits); }
+        HostRegister8& operator&=(uint8_t bits) { return *this = (uint8_t)(*this & bits); }
+        HostRegister8& operator^=(uint8_t bits) { return *this = (uint8_t)(*this ^ bits); }
+
+        /**
+         * @brief Stored value, accessed directly by the simulation.
+         */
+        volatile uint8_t value;
+
+        /**
+         * @brief Identifier of the register for its hooks.
+         */
+        const uint8_t id;
+
+    private:
+        readHook_t onRead;
+        writeHook_t onWrite;
+};
+
+/**
+ * @brief 16-bit I/O register (timer counters and compare registers, ADC, baud rate).
+ */
+class HostRegister16 {
+    public:
+        typedef uint16_t (*readHook_t)(const HostRegister16& reg);
+        typedef void (*writeHook_t)(HostRegister16& reg, uint16_t value);
+
+        explicit HostRegister16(uint8_t id = 0, readHook_t onRead = nullptr, writeHook_t onWrite = nullptr)
+            : value(0), id(id), onRead(onRead), onWrite(onWrite) {}
+
+        HostRegister16(const HostRegister16&) = delete;
+
+        operator uint16_t() const { return onRead ? onRead(*this) : value; }
+
+        HostRegister16& operator=(uint16_t newValue) {
+            if (onWrite) {
+                onWrite(*this, newValue);
+            } else {
+                value = newValue;
+            }
+            return *this;
+        }
+
+        HostRegister16& operator=(const HostRegister16& other) { return *this = (uint16_t)other; }
+        HostRegister16& operator|=(uint16_t bits) { return *this = (uint16_t)(*this | bits); }
+        HostRegister16& operator&=(uint16_t bits) { return *this = (uint16_t)(*this & bits); }
+
+        volatile uint16_t value;
+
+        const uint8_t id;
+
+    private:
+        readHook_t onRead;
+        writeHook_t onWrite;
+};
+
+//=============================================================================
+//                                   MACROS
+//=============================================================================
+
+#define _BV(bit) (1 << (bit))
+
+#define bit_is_set(reg, bit) ((reg) & _BV(bit))
+#define bit_is_clear(reg, bit) (!((reg) & _BV(bit)))
+
+/**
+ * @brief Declares the PINx, DDRx and PORTx registers of a port.
+ */
+#define HOST_PORT(x) extern HostRegister8 PIN##x, DDR##x, PORT##x;
+
+// Status register
+#define SREG_I 7
+
+// Ports
+#define PA0 0
+#define PA1 1
+#define PA2 2
+#define PA3 3
+#define PA4 4
+#define PA5 5
+#define PA6 6
+#define PA7 7
+
+#define PB0 0
+#define PB1 1
+#define PB2 2
+#define PB3 3
+#define PB4 4
+#define PB5 5
+#define PB6 6
+#define PB7 7
+
+#define PE0 0
+#define PE1 1
+#define PE2 2
+#define PE3 3
+#define PE4 4
+#define PE5 5
+#define PE6 6
+#define PE7 7
+
+#define PG0 0
+#define PG1 1
+#define PG2 2
+#define PG3 3
+#define PG4 4
+#define PG5 5
+
+#define PH0 0
+#define PH1 1
+#define PH2 2
+#define PH3 3
+#define PH4 4
+#define PH5 5
+#define PH6 6
+#define PH7 7
+
+// External interrupts
+#define ISC00 0
+#define ISC01 1
+#define ISC10 2
+#define ISC11 3
+#define ISC20 4
+#define ISC21 5
+#define ISC30 6
+#define ISC31 7
+#define ISC40 0
+#define ISC41 1
+#define ISC50 2
+#define ISC51 3
+#define ISC60 4
+#define ISC61 5
+#define ISC70 6
+#define ISC71 7
+
+#define INT0 0
+#define INT1 1
+#define INT2 2
+#define INT3 3
+#define INT4 4
+#define INT5 5
+#define INT6 6
+#define INT7 7
+
+#define INTF0 0
+#define INTF1 1
+#define INTF2 2
+#define INTF3 3
+#define INTF4 4
+#define INTF5 5
+#define INTF6 6
+#define INTF7 7
+
+// Timer1
+#define WGM10 0
+#define WGM11 1
+#define COM1A0 6
+#define COM1A1 7
+#define CS10 0
+#define CS11 1
+#define CS12 2
+#define WGM12 3
+#define WGM13 4
+#define OCIE1A 1
+#define OCF1A 1
+
+// Timer2
+#define WGM20 0
+#define WGM21 1
+#define COM2A0 6
+#define COM2A1 7
+#define CS20 0
+#define CS21 1
+#define CS22 2
+#define WGM22 3
+
+// Timer3
+#define WGM30 0
+#define WGM31 1
+#define COM3A0 6
+#define COM3A1 7
+#define CS30 0
+#define CS31 1
+#define CS32 2
+#define WGM32 3
+#define WGM33 4
+
+// Timer5
+#define CS50 0
+#define CS51 1
+#define CS52 2
+#define TOIE5 0
+#define TOV5 0
+
+// ADC
+#define MUX0 0
+#define MUX1 1
+#define MUX2 2
+#define MUX3 3
+#define MUX4 4
+#define ADLAR 5
+#define REFS0 6
+#define REFS1 7
+#define ADPS0 0
+#define ADPS1 1
+#define ADPS2 2
+#define ADIE 3
+#define ADIF 4
+#define ADATE 5
+#define ADSC 6
+#define ADEN 7
+#define MUX5 3
+#define ADC0D 0
+#define ADC1D 1
+
+// USART1
+#define MPCM1 0
+#define U2X1 1
+#define UPE1 2
+#define DOR1 3
+#define FE1 4
+#define UDRE1 5
+#define TXC1 6
+#define RXC1 7
+#define TXB81 0
+#define RXB81 1
+#define UCSZ12 2
+#define TXEN1 3
+#define RXEN1 4
+#define UDRIE1 5
+#define TXCIE1 6
+#define RXCIE1 7
+#define UCSZ10 1
+#define UCSZ11 2
+
+// Sleep mode control
+#define SE 0
+#define SM0 1
+#define SM1 2
+#define SM2 3
+
+//=============================================================================
+//                              VARIABLE DECLARATIONS
+//=============================================================================
+
+extern HostRegister8 SREG;
+
+HOST_PORT(A) HOST_PORT(B) HOST_PORT(C) HOST_PORT(D) HOST_PORT(E) HOST_PORT(F)
+HOST_PORT(G) HOST_PORT(H) HOST_PORT(J) HOST_PORT(K) HOST_PORT(L)
+
+extern HostRegister8 EICRA, EICRB, EIMSK, EIFR;
+
+extern HostRegister8 TCCR1A, TCCR1B, TCCR1C, TIMSK1, TIFR1;
+extern HostRegister16 TCNT1, OCR1A, OCR1B, ICR1;
+
+extern HostRegister8 TCCR2A, TCCR2B, TCNT2, OCR2A, OCR2B, TIMSK2, TIFR2;
+
+extern HostRegister8 TCCR3A, TCCR3B, TCCR3C, TIMSK3, TIFR3;
+extern HostRegister16 TCNT3, OCR3A, OCR3B, OCR3C, ICR3;
+
+extern HostRegister8 TCCR5A, TCCR5B, TCCR5C, TIMSK5, TIFR5;
+extern HostRegister16 TCNT5, OCR5A, OCR5B, OCR5C, ICR5;
+
+extern HostRegister8 ADMUX, ADCSRA, ADCSRB, DIDR0, DIDR2;
+extern HostRegister16 ADC;
+
+extern HostRegister8 UCSR1A, UCSR1B, UCSR1C, UDR1;
+extern HostRegister16 UBRR1;
+
+extern HostRegister8 UCSR2A, UCSR2B, UCSR2C, UDR2;
+extern HostRegister16 UBRR2;
+
+extern HostRegister8 SMCR;
@@ -0,0 +1,32 @@
+/**
+* @file pgmspace.h
+* @brief Program memory access of the host simulation.
+* @details The host has a single address space: PROGMEM data is ordinary constant data and is read directly.
+*/
+
+#pragma once
+
+//=============================================================================
+//                       INCLUDE LIBRARIES AND HEADER FILES
+//=============================================================================
+
+#include <stdint.h>
+#include <string.h>
+
+//=============================================================================
+//                                   MACROS
+//=============================================================================
+
+#define PROGMEM
+#define PGM_P const char*
+#define PSTR(s) (s)
+
+#define pgm_read_byte(address) (*(const uint8_t*)(address))
+#define pgm_read_word(address) (*(const uint16_t*)(address))
+#define pgm_read_dword(address) (*(const uint32_t*)(address))
+#define pgm_read_ptr(address) (*(void* const*)(address))
+
+#define memcpy_P memcpy
+#define strlen_P strlen
+#define strcpy_P strcpy
+#define strcmp_P strcmp
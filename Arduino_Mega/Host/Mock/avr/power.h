@@ -0,0 +1,20 @@
+/**
+* @file power.h
+* @brief Power reduction of the host simulation.
+* @details The simulated peripherals are never powered down: the macros only exist so that the firmware builds.
+*/
+
+#pragma once
+
+//=============================================================================
+//                                   MACROS
+//=============================================================================
+
+#define power_adc_enable()
+#define power_adc_disable()
+#define power_spi_enable()
+#define power_spi_disable()
+#define power_twi_enable()
+#define power_twi_disable()
+#define power_all_enable()
+#define power_all_disable()
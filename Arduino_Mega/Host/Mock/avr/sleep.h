@@ -0,0 +1,38 @@
+/**
+* @file sleep.h
+* @brief Sleep modes of the host simulation.
+* @details Sleeping advances the virtual time to the next interrupt, or to the next Timer0 overflow which wakes the CPU every 1024 µs.
+*/
+
+#pragma once
+
+//=============================================================================
+//                       INCLUDE LIBRARIES AND HEADER FILES
+//=============================================================================
+
+#include <avr/io.h>
+
+//=============================================================================
+//                                   MACROS
+//=============================================================================
+
+#define SLEEP_MODE_IDLE 0
+#define SLEEP_MODE_ADC _BV(SM0)
+#define SLEEP_MODE_PWR_DOWN _BV(SM1)
+#define SLEEP_MODE_PWR_SAVE (_BV(SM0) | _BV(SM1))
+#define SLEEP_MODE_STANDBY (_BV(SM1) | _BV(SM2))
+
+#define set_sleep_mode(mode) (SMCR = (SMCR & ~(_BV(SM0) | _BV(SM1) | _BV(SM2))) | (mode))
+#define sleep_enable() (SMCR |= _BV(SE))
+#define sleep_disable() (SMCR &= ~_BV(SE))
+#define sleep_cpu() hostSleep()
+#define sleep_mode() do { sleep_enable(); sleep_cpu(); sleep_disable(); } while (0)
+
+//=============================================================================
+//                           ROUTINE PROTOTYPES
+//=============================================================================
+
+/**
+ * @brief Advances the virtual time to the next wake-up source, see host.cpp.
+ */
+extern void hostSleep();
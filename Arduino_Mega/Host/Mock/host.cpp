@@ -0,0 +1,1148 @@
+/**
+* @file host.cpp
+* @brief Simulated ATmega2560 peripherals and virtual time of the host simulation.
+* @details The peripherals used by the firmware are simulated at the register level, with the timing of a 16 MHz board:
+*          - SREG: clearing the I flag holds the interrupts off, setting it services the pending ones.
+*          - Ports A to L: pin levels, pull-ups, PINx toggling and the external interrupts INT0 to INT7.
+*          - Timer1: counter in CTC mode raising TIMER1_COMPA at each compare match.
+*          - Timer2 and Timer3: the duty cycles of the motor PWM outputs (OCR2A and OCR3A), timestamped on change.
+*          - Timer5: counter at the prescaled clock, raising TIMER5_OVF on overflow.
+*          - ADC: conversions of 13 ADC clocks raising ADC_vect.
+*          - USART0: the USB serial port (HardwareSerial Serial).
+*          - USART1: the Bluetooth module, with the 2-byte receive FIFO, the receive shift register and the data overrun flag.
+*          - Heap: the memory allocated with malloc() by the firmware and the mock libraries, the calls being wrapped at link
+*            time (see CMakeLists.txt). The allocations of the C++ containers of the simulation are not counted.
+*          Time is counted in picoseconds so that one CPU cycle (62.5 ns) and one byte at any baud rate are exact enough.
+*          The code of the firmware, interrupt routines included, is timed with the CPU time clock of the host thread: the
+*          virtual time advances by its execution time, times the CPU scale, whenever it calls the simulation (see
+*          HostCall). The time spent in the simulation itself, in the scenarios and preempted by other processes is not
+*          counted.
+*/
+
+//=============================================================================
+//                       INCLUDE LIBRARIES AND HEADER FILES
+//=============================================================================
+
+#include <deque>
+#include <string>
+
+#include <malloc.h>
+#include <time.h>
+
+#include "host.h"
+
+#include <Arduino.h>
+#include <avr/sleep.h>
+
+//=============================================================================
+//                              TYPE DECLARATIONS
+//=============================================================================
+
+/**
+ * @brief Byte sent by the Bluetooth module, received by USART1 at its arrival time.
+ */
+typedef struct hostSerialByte_t {
+    uint64_t time;  /**< End of the stop bit (ps) */
+    uint8_t byte;   /**< Received byte */
+} hostSerialByte_t;
+
+/**
+ * @brief State of a port seen from outside the board.
+ */
+typedef struct hostPort_t {
+    uint8_t driven;                 /**< Pins driven by the simulation, see hostSetPin() */
+    uint8_t external;               /**< Levels of the driven pins */
+    uint8_t level;                  /**< Current levels of the pins */
+    unsigned long toggles[8];       /**< Level changes of each pin */
+} hostPort_t;
+
+//=============================================================================
+//                                   MACROS
+//=============================================================================
+
+/**
+ * @brief Time of an event that is not scheduled.
+ */
+#define NEVER UINT64_MAX
+
+/**
+ * @brief Duration of a CPU cycle at 16 MHz (ps).
+ */
+#define CYCLE_PS 62500ULL
+
+/**
+ * @brief Period of the Timer0 overflow interrupt of the Arduino core, which wakes the CPU from idle (ps).
+ */
+#define TIMER0_OVERFLOW_PS (1024ULL * 1000000ULL)
+
+/**
+ * @brief Size of the transmit buffer of the USB serial port, as in the Arduino core.
+ */
+#define SERIAL_TX_BUFFER_SIZE 64
+
+/**
+ * @brief Number of ports A to L (there is no port I).
+ */
+#define PORT_COUNT 11
+
+//=============================================================================
+//                              ROUTINE PROTOTYPES
+//=============================================================================
+
+static void writeSreg(HostRegister8& reg, uint8_t value);
+static uint8_t readPin(const HostRegister8& reg);
+static void writePin(HostRegister8& reg, uint8_t value);
+static void writePortOrDdr(HostRegister8& reg, uint8_t value);
+static void clearOnWrite(HostRegister8& reg, uint8_t value);
+static void writeTccr1b(HostRegister8& reg, uint8_t value);
+static uint16_t readTcnt1(const HostRegister16& reg);
+static void writeTcnt1(HostRegister16& reg, uint16_t value);
+static void writeOcr1a(HostRegister16& reg, uint16_t value);
+static void writeMotorPwm8(HostRegister8& reg, uint8_t value);
+static void writeMotorPwm16(HostRegister16& reg, uint16_t value);
+static void writeTccr5b(HostRegister8& reg, uint8_t value);
+static uint16_t readTcnt5(const HostRegister16& reg);
+static void writeTcnt5(HostRegister16& reg, uint16_t value);
+static void writeAdcsra(HostRegister8& reg, uint8_t value);
+static uint8_t readUcsr1a(const HostRegister8& reg);
+static void writeUcsr1a(HostRegister8& reg, uint8_t value);
+static uint8_t readUdr1(const HostRegister8& reg);
+static void writeUdr1(HostRegister8& reg, uint8_t value);
+static void advanceTo(uint64_t target);
+
+//=============================================================================
+//                             VARIABLE DEFINITIONS
+//=============================================================================
+
+HostRegister8 SREG(0, nullptr, writeSreg);
+
+#define HOST_PORT_DEFINITION(x, index) \
+    HostRegister8 PIN##x(index, readPin, writePin), DDR##x(index, nullptr, writePortOrDdr), PORT##x(index, nullptr, writePortOrDdr);
+
+HOST_PORT_DEFINITION(A, 0) HOST_PORT_DEFINITION(B, 1) HOST_PORT_DEFINITION(C, 2) HOST_PORT_DEFINITION(D, 3)
+HOST_PORT_DEFINITION(E, 4) HOST_PORT_DEFINITION(F, 5) HOST_PORT_DEFINITION(G, 6) HOST_PORT_DEFINITION(H, 7)
+HOST_PORT_DEFINITION(J, 8) HOST_PORT_DEFINITION(K, 9) HOST_PORT_DEFINITION(L, 10)
+
+HostRegister8 EICRA, EICRB, EIMSK, EIFR(0, nullptr, clearOnWrite);
+
+HostRegister8 TCCR1A, TCCR1B(0, nullptr, writeTccr1b), TCCR1C, TIMSK1, TIFR1(0, nullptr, clearOnWrite);
+HostRegister16 TCNT1(0, readTcnt1, writeTcnt1), OCR1A(0, nullptr, writeOcr1a), OCR1B, ICR1;
+
+HostRegister8 TCCR2A, TCCR2B, TCNT2, OCR2A(0, nullptr, writeMotorPwm8), OCR2B, TIMSK2, TIFR2(0, nullptr, clearOnWrite);
+
+HostRegister8 TCCR3A, TCCR3B, TCCR3C, TIMSK3, TIFR3(0, nullptr, clearOnWrite);
+HostRegister16 TCNT3, OCR3A(0, nullptr, writeMotorPwm16), OCR3B, OCR3C, ICR3;
+
+HostRegister8 TCCR5A, TCCR5B(0, nullptr, writeTccr5b), TCCR5C, TIMSK5, TIFR5(0, nullptr, clearOnWrite);
+HostRegister16 TCNT5(0, readTcnt5, writeTcnt5), OCR5A, OCR5B, OCR5C, ICR5;
+
+HostRegister8 ADMUX, ADCSRA(0, nullptr, writeAdcsra), ADCSRB, DIDR0, DIDR2;
+HostRegister16 ADC;
+
+HostRegister8 UCSR1A(0, readUcsr1a, writeUcsr1a), UCSR1B, UCSR1C, UDR1(0, readUdr1, writeUdr1);
+HostRegister16 UBRR1;
+
+HostRegister8 UCSR2A, UCSR2B, UCSR2C, UDR2;
+HostRegister16 UBRR2;
+
+HostRegister8 SMCR;
+
+HardwareSerial Serial;
+
+/**
+ * @brief Virtual time (ps).
+ */
+static uint64_t now = 0;
+
+/**
+ * @brief Number of nested calls to the simulation, 0 while the firmware runs. The scenarios run in the simulation.
+ */
+static unsigned hostDepth = 1;
+
+/**
+ * @brief CPU time of the host thread the firmware started running at (ns), and factor applied to its execution time.
+ */
+static uint64_t firmwareStart = 0;
+static double cpuScale = 1.0;
+
+/**
+ * @brief True while an interrupt service routine runs.
+ */
+static bool servicing = false;
+
+/**
+ * @brief Time the interrupts were last disabled, and longest time they stayed disabled (ps).
+ */
+static uint64_t interruptsOffTime = 0;
+static uint64_t interruptsOffMax = 0;
+
+static HostRegister8* const pinRegisters[PORT_COUNT] = { &PINA, &PINB, &PINC, &PIND, &PINE, &PINF, &PING, &PINH, &PINJ, &PINK, &PINL };
+static HostRegister8* const ddrRegisters[PORT_COUNT] = { &DDRA, &DDRB, &DDRC, &DDRD, &DDRE, &DDRF, &DDRG, &DDRH, &DDRJ, &DDRK, &DDRL };
+static HostRegister8* const portRegisters[PORT_COUNT] = { &PORTA, &PORTB, &PORTC, &PORTD, &PORTE, &PORTF, &PORTG, &PORTH, &PORTJ, &PORTK, &PORTL };
+
+static hostPort_t ports[PORT_COUNT];
+
+/**
+ * @brief External interrupt vectors, indexed by interrupt number. INT0 to INT3 are PD0 to PD3, INT4 to INT7 are PE4 to PE7.
+ */
+static void (* const externalVectors[8])(void) = {
+    INT0_vect, INT1_vect, INT2_vect, INT3_vect, INT4_vect, INT5_vect, INT6_vect, INT7_vect
+};
+
+/**
+ * @brief Clock prescalers of timers 1 and 5, indexed by their CSn2:0 bits. 0 for a stopped timer or an external clock.
+ */
+static const uint16_t timerPrescalers[8] = { 0, 1, 8, 64, 256, 1024, 0, 0 };
+
+/**
+ * @brief Time TCNT1 was 0, time of the next compare match, and count of the stopped timer.
+ */
+static uint64_t timer1Zero = 0;
+static uint64_t timer1Match = NEVER;
+static uint16_t timer1Count = 0;
+
+/**
+ * @brief Time a duty cycle of the motor PWM outputs last changed (ps).
+ */
+static uint64_t motorPwmChange = 0;
+
+/**
+ * @brief Time TCNT5 was 0, time of the next overflow, and count of the stopped timer.
+ */
+static uint64_t timer5Zero = 0;
+static uint64_t timer5Overflow = NEVER;
+static uint16_t timer5Count = 0;
+
+/**
+ * @brief End of the running ADC conversion, and values of the analog inputs.
+ */
+static uint64_t adcDone = NEVER;
+static uint16_t analogInputs[16];
+
+/**
+ * @brief USART1 receiver: bytes sent by the module, 2-byte FIFO, shift register and data overrun flag.
+ */
+static std::deque<hostSerialByte_t> bluetoothQueue;
+static uint64_t bluetoothLastArrival = 0;
+static uint8_t uart1Fifo[2];
+static uint8_t uart1Count = 0;
+static uint8_t uart1Shift = 0;
+static bool uart1ShiftFull = false;
+static bool uart1Overrun = false;
+static std::string bluetoothSent;
+
+/**
+ * @brief USB serial port: received characters, sent characters and end of the transmission of the buffered ones.
+ */
+static std::deque<uint8_t> serialInput;
+static std::string serialOutput;
+static bool serialEcho = true;
+static unsigned long serialBaud = 0;
+static uint64_t serialTxEnd = 0;
+
+/**
+ * @brief LED strip: colors displayed, colors of the frame being received, length and statistics.
+ */
+static std::string stripFrame;
+static std::string stripData;
+static uint16_t stripBytes = 0;
+static uint64_t stripLastData = 0;
+static hostStripStats_t stripStats = { 0, 0, 0 };
+
+/**
+ * @brief Bytes allocated by malloc(), calloc() and realloc() and not freed yet.
+ */
+static size_t heapUsed = 0;
+
+//=============================================================================
+//                              ROUTINE DEFINITIONS
+//=============================================================================
+
+/**
+ * @brief Converts a duration in µs to ps.
+ */
+static inline uint64_t microsToPs(uint64_t us) {
+    return us * 1000000ULL;
+}
+
+//-----------------------------------------------------------------------------
+// Execution time of the firmware
+//-----------------------------------------------------------------------------
+
+/**
+ * @brief Gets the CPU time of the host thread (ns).
+ */
+static uint64_t threadCpuTime() {
+    struct timespec time;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &time);
+    return time.tv_sec * 1000000000ULL + time.tv_nsec;
+}
+
+/**
+ * @brief Advances the virtual time by the execution time of the firmware since it started running.
+ */
+static void chargeFirmware() {
+    uint64_t end = threadCpuTime();
+    uint64_t elapsed = end - firmwareStart;
+
+    firmwareStart = end;
+    advanceTo(now + (uint64_t)(elapsed * 1000.0 * cpuScale));
+}
+
+HostCall::HostCall() {
+    if (hostDepth++ == 0) {
+        chargeFirmware();
+    }
+}
+
+HostCall::~HostCall() {
+    if (--hostDepth == 0) {
+        firmwareStart = threadCpuTime();
+    }
+}
+
+void hostRunFirmware(void (*code)(void)) {
+    unsigned depth = hostDepth;
+
+    hostDepth = 0;
+    firmwareStart = threadCpuTime();
+    code();
+
+    hostDepth = 1;
+    chargeFirmware();
+    hostDepth = depth;
+}
+
+void hostSetCpuScale(double scale) {
+    cpuScale = scale;
+}
+
+//-----------------------------------------------------------------------------
+// Interrupts
+//-----------------------------------------------------------------------------
+
+/**
+ * @brief Finds the pending interrupt of highest priority and acknowledges it.
+ * @return Its vector, NULL if no enabled interrupt is pending.
+ */
+static void (*takePendingVector())(void) {
+    for (uint8_t i = 0; i < 8; i++) {
+        if (!(EIMSK.value & _BV(i))) {
+            continue;
+        }
+
+        uint8_t sense = ((i < 4 ? EICRA.value : EICRB.value) >> (2 * (i & 3))) & 0x03;
+        bool low = i < 4 ? !(ports[3].level & _BV(i)) : !(ports[4].level & _BV(i));
+
+        // Level interrupt: pending as long as the pin is low, without flag
+        if (sense == 0 ? low : (EIFR.value & _BV(i)) != 0) {
+            EIFR.value &= ~_BV(i);
+            return externalVectors[i];
+        }
+    }
+
+    if ((TIMSK1.value & _BV(OCIE1A)) && (TIFR1.value & _BV(OCF1A))) {
+        TIFR1.value &= ~_BV(OCF1A);
+        return TIMER1_COMPA_vect;
+    }
+
+    if ((ADCSRA.value & _BV(ADIE)) && (ADCSRA.value & _BV(ADIF))) {
+        ADCSRA.value &= ~_BV(ADIF);
+        return ADC_vect;
+    }
+
+    // The receive complete flag stays set until UDR1 is read by the routine
+    if ((UCSR1B.value & _BV(RXCIE1)) && uart1Count > 0) {
+        return USART1_RX_vect;
+    }
+
+    if ((TIMSK5.value & _BV(TOIE5)) && (TIFR5.value & _BV(TOV5))) {
+        TIFR5.value &= ~_BV(TOV5);
+        return TIMER5_OVF_vect;
+    }
+
+    return NULL;
+}
+
+void hostServiceInterrupts() {
+    if (servicing) {
+        return;
+    }
+
+    while (SREG.value & _BV(SREG_I)) {
+        void (*vector)(void) = takePendingVector();
+
+        if (vector == NULL) {
+            break;
+        }
+
+        // The I flag is cleared while the routine runs, and set again by RETI
+        servicing = true;
+        SREG.value &= ~_BV(SREG_I);
+        hostRunFirmware(vector);
+        SREG.value |= _BV(SREG_I);
+        servicing = false;
+    }
+}
+
+static void writeSreg(HostRegister8& reg, uint8_t value) {
+    HostCall call;
+    uint8_t previous = reg.value;
+    reg.value = value;
+
+    if (servicing) {
+        return;
+    }
+
+    if ((previous & _BV(SREG_I)) && !(value & _BV(SREG_I))) {
+        interruptsOffTime = now;
+    } else if (!(previous & _BV(SREG_I)) && (value & _BV(SREG_I))) {
+        if (now - interruptsOffTime > interruptsOffMax) {
+            interruptsOffMax = now - interruptsOffTime;
+        }
+        hostServiceInterrupts();
+    }
+}
+
+unsigned long hostMaxInterruptsOff() {
+    unsigned long us = interruptsOffMax / 1000000ULL;
+    interruptsOffMax = 0;
+    return us;
+}
+
+/**
+ * @brief Clears the flags written to one, as the interrupt flag registers.
+ */
+static void clearOnWrite(HostRegister8& reg, uint8_t value) {
+    reg.value &= ~value;
+}
+
+//-----------------------------------------------------------------------------
+// Ports and external interrupts
+//-----------------------------------------------------------------------------
+
+/**
+ * @brief Updates the pin levels of a port after a change of its registers or of the external levels.
+ * @details Undriven input pins read their pull-up. Level changes of the INT0 to INT7 pins raise their interrupt flag
+ *          according to their sense control bits.
+ */
+static void updatePort(uint8_t index) {
+    hostPort_t* port = &ports[index];
+    uint8_t ddr = ddrRegisters[index]->value;
+    uint8_t out = portRegisters[index]->value;
+    uint8_t input = (port->driven & port->external) | (~port->driven & out);
+    uint8_t level = (ddr & out) | (~ddr & input);
+    uint8_t changed = level ^ port->level;
+
+    port->level = level;
+
+    for (uint8_t bit = 0; bit < 8; bit++) {
+        if (!(changed & _BV(bit))) {
+            continue;
+        }
+
+        port->toggles[bit]++;
+
+        int8_t interrupt = (index == 3 && bit < 4) ? bit : (index == 4 && bit >= 4) ? bit : -1;
+        if (interrupt < 0) {
+            continue;
+        }
+
+        uint8_t sense = ((interrupt < 4 ? EICRA.value : EICRB.value) >> (2 * (interrupt & 3))) & 0x03;
+        bool rising = (level & _BV(bit)) != 0;
+
+        if (sense == 1 || (sense == 2 && !rising) || (sense == 3 && rising)) {
+            EIFR.value |= _BV(interrupt);
+        }
+    }
+
+    hostServiceInterrupts();
+}
+
+static uint8_t readPin(const HostRegister8& reg) {
+    return ports[reg.id].level;
+}
+
+/**
+ * @brief Writing ones to PINx toggles the corresponding PORTx bits.
+ */
+static void writePin(HostRegister8& reg, uint8_t value) {
+    *portRegisters[reg.id] = portRegisters[reg.id]->value ^ value;
+}
+
+static void writePortOrDdr(HostRegister8& reg, uint8_t value) {
+    HostCall call;
+    reg.value = value;
+    updatePort(reg.id);
+}
+
+/**
+ * @brief Finds the port and bit of an Arduino pin.
+ * @return False if the pin does not exist.
+ */
+static bool findPin(uint8_t pin, uint8_t* index, uint8_t* mask) {
+    uint8_t port = digitalPinToPort(pin);
+
+    if (port == NOT_A_PIN) {
+        return false;
+    }
+
+    // Port numbers of the Arduino core: PA = 1 to PL = 12, without PI = 9
+    *index = port - 1 - (port > 9 ? 1 : 0);
+    *mask = digitalPinToBitMask(pin);
+    return true;
+}
+
+void hostSetPin(uint8_t pin, uint8_t level) {
+    uint8_t index, mask;
+
+    if (findPin(pin, &index, &mask)) {
+        ports[index].driven |= mask;
+        ports[index].external = level ? (ports[index].external | mask) : (ports[index].external & ~mask);
+        updatePort(index);
+    }
+}
+
+void hostReleasePin(uint8_t pin) {
+    uint8_t index, mask;
+
+    if (findPin(pin, &index, &mask)) {
+        ports[index].driven &= ~mask;
+        updatePort(index);
+    }
+}
+
+uint8_t hostGetPin(uint8_t pin) {
+    uint8_t index, mask;
+    return (findPin(pin, &index, &mask) && (ports[index].level & mask)) ? HIGH : LOW;
+}
+
+unsigned long hostPinToggles(uint8_t pin) {
+    uint8_t index, mask;
+
+    if (!findPin(pin, &index, &mask)) {
+        return 0;
+    }
+
+    uint8_t bit = 0;
+    while (!(mask & _BV(bit))) {
+        bit++;
+    }
+    return ports[index].toggles[bit];
+}
+
+//-----------------------------------------------------------------------------
+// Timer1
+//-----------------------------------------------------------------------------
+
+/**
+ * @brief Gets the period of a Timer1 tick (ps), 0 if the timer is stopped.
+ */
+static uint64_t timer1Tick() {
+    return timerPrescalers[TCCR1B.value & 0x07] * CYCLE_PS;
+}
+
+/**
+ * @brief Gets the current value of TCNT1.
+ */
+static uint16_t timer1Value() {
+    uint64_t tick = timer1Tick();
+
+    if (tick == 0) {
+        return timer1Count;
+    }
+
+    return (now < timer1Zero) ? 0 : (uint16_t)((now - timer1Zero) / tick);
+}
+
+/**
+ * @brief Schedules the next compare match of OCR1A. The counter runs up to 0xFFFF and wraps if it has passed OCR1A.
+ */
+static void scheduleTimer1() {
+    uint64_t tick = timer1Tick();
+
+    if (tick == 0) {
+        timer1Match = NEVER;
+        return;
+    }
+
+    uint64_t count = (now < timer1Zero) ? 0 : (now - timer1Zero) / tick;
+
+    if (count > OCR1A.value) {
+        timer1Zero += 65536 * tick;
+    }
+
+    timer1Match = timer1Zero + OCR1A.value * tick;
+}
+
+/**
+ * @brief Restarts the counter from a value.
+ */
+static void setTimer1Value(uint16_t value) {
+    uint64_t tick = timer1Tick();
+    uint64_t elapsed = value * tick;
+
+    timer1Count = value;
+    timer1Zero = (now > elapsed) ? now - elapsed : 0;
+    scheduleTimer1();
+}
+
+static void writeTccr1b(HostRegister8& reg, uint8_t value) {
+    HostCall call;
+    uint16_t count = timer1Value();
+    reg.value = value;
+    setTimer1Value(count);
+}
+
+static uint16_t readTcnt1(const HostRegister16&) {
+    HostCall call;
+    return timer1Value();
+}
+
+static void writeTcnt1(HostRegister16&, uint16_t value) {
+    HostCall call;
+    setTimer1Value(value);
+}
+
+static void writeOcr1a(HostRegister16& reg, uint16_t value) {
+    HostCall call;
+    reg.value = value;
+    scheduleTimer1();
+}
+
+/**
+ * @brief Compare match: raises the interrupt flag, the counter is cleared on the next tick (CTC mode).
+ */
+static void matchTimer1() {
+    TIFR1.value |= _BV(OCF1A);
+    timer1Zero = timer1Match + timer1Tick();
+    timer1Match = timer1Zero + OCR1A.value * timer1Tick();
+}
+
+//-----------------------------------------------------------------------------
+// Timer2 and Timer3: motor PWM
+//-----------------------------------------------------------------------------
+
+static void writeMotorPwm8(HostRegister8& reg, uint8_t value) {
+    HostCall call;
+
+    if (value != reg.value) {
+        motorPwmChange = now;
+    }
+    reg.value = value;
+}
+
+static void writeMotorPwm16(HostRegister16& reg, uint16_t value) {
+    HostCall call;
+
+    if (value != reg.value) {
+        motorPwmChange = now;
+    }
+    reg.value = value;
+}
+
+uint64_t hostMotorPwmChangeTime() {
+    return motorPwmChange / 1000;
+}
+
+//-----------------------------------------------------------------------------
+// Timer5
+//-----------------------------------------------------------------------------
+
+/**
+ * @brief Gets the period of a Timer5 tick (ps), 0 if the timer is stopped.
+ */
+static uint64_t timer5Tick() {
+    return timerPrescalers[TCCR5B.value & 0x07] * CYCLE_PS;
+}
+
+/**
+ * @brief Gets the current value of TCNT5. The counter runs in normal mode, from 0 to 0xFFFF.
+ */
+static uint16_t timer5Value() {
+    uint64_t tick = timer5Tick();
+
+    if (tick == 0) {
+        return timer5Count;
+    }
+
+    return (now < timer5Zero) ? 0 : (uint16_t)((now - timer5Zero) / tick);
+}
+
+/**
+ * @brief Restarts the counter from a value and schedules its next overflow.
+ */
+static void setTimer5Value(uint16_t value) {
+    uint64_t tick = timer5Tick();
+    uint64_t elapsed = value * tick;
+
+    timer5Count = value;
+    timer5Zero = (now > elapsed) ? now - elapsed : 0;
+    timer5Overflow = (tick == 0) ? NEVER : timer5Zero + 65536 * tick;
+}
+
+static void writeTccr5b(HostRegister8& reg, uint8_t value) {
+    HostCall call;
+    uint16_t count = timer5Value();
+    reg.value = value;
+    setTimer5Value(count);
+}
+
+static uint16_t readTcnt5(const HostRegister16&) {
+    HostCall call;
+    return timer5Value();
+}
+
+static void writeTcnt5(HostRegister16&, uint16_t value) {
+    HostCall call;
+    setTimer5Value(value);
+}
+
+/**
+ * @brief Overflow: raises the interrupt flag, the counter wraps to 0.
+ */
+static void overflowTimer5() {
+    TIFR5.value |= _BV(TOV5);
+    timer5Zero = timer5Overflow;
+    timer5Overflow = timer5Zero + 65536 * timer5Tick();
+}
+
+//-----------------------------------------------------------------------------
+// ADC
+//-----------------------------------------------------------------------------
+
+/**
+ * @brief Starts a conversion when ADSC is written, clears the ADIF flag when it is written to one.
+ */
+static void writeAdcsra(HostRegister8& reg, uint8_t value) {
+    HostCall call;
+    uint8_t flag = (value & _BV(ADIF)) ? 0 : (reg.value & _BV(ADIF));
+    reg.value = (value & ~_BV(ADIF)) | flag;
+
+    if (!(value & _BV(ADEN))) {
+        adcDone = NEVER;
+        reg.value &= ~_BV(ADSC);
+        return;
+    }
+
+    if ((value & _BV(ADSC)) && adcDone == NEVER) {
+        // 13 ADC clocks per conversion, the prescaler is at least 2
+        uint8_t prescaler = 1 << max(1, value & 0x07);
+        adcDone = now + 13ULL * prescaler * CYCLE_PS;
+    }
+
+    if (adcDone != NEVER) {
+        reg.value |= _BV(ADSC);
+    }
+}
+
+static void completeAdcConversion() {
+    uint8_t channel = (ADMUX.value & 0x07) | ((ADCSRB.value & _BV(MUX5)) ? 0x08 : 0);
+
+    ADC.value = analogInputs[channel] & 0x3FF;
+    ADCSRA.value = (ADCSRA.value & ~_BV(ADSC)) | _BV(ADIF);
+    adcDone = NEVER;
+}
+
+void hostSetAnalog(uint8_t channel, uint16_t value) {
+    analogInputs[channel & 0x0F] = value;
+}
+
+//-----------------------------------------------------------------------------
+// USART1: Bluetooth module
+//-----------------------------------------------------------------------------
+
+/**
+ * @brief Receives a byte: it goes to the FIFO, or waits in the shift register if the FIFO is full. A byte arriving
+ *        while both are full overwrites the shift register: a data overrun.
+ */
+static void receiveUart1(uint8_t byte) {
+    if (!(UCSR1B.value & _BV(RXEN1))) {
+        return;
+    }
+
+    if (uart1Count < 2) {
+        uart1Fifo[uart1Count++] = byte;
+    } else if (!uart1ShiftFull) {
+        uart1Shift = byte;
+        uart1ShiftFull = true;
+    } else {
+        uart1Shift = byte;
+        uart1Overrun = true;
+    }
+}
+
+static uint8_t readUcsr1a(const HostRegister8& reg) {
+    HostCall call;
+    return (reg.value & (_BV(U2X1) | _BV(MPCM1))) | _BV(UDRE1) | _BV(TXC1)
+           | (uart1Count > 0 ? _BV(RXC1) : 0) | (uart1Overrun ? _BV(DOR1) : 0);
+}
+
+static void writeUcsr1a(HostRegister8& reg, uint8_t value) {
+    reg.value = value & (_BV(U2X1) | _BV(MPCM1));
+}
+
+/**
+ * @brief Pops the FIFO, which clears the data overrun flag and moves the shift register into the FIFO.
+ */
+static uint8_t readUdr1(const HostRegister8& reg) {
+    HostCall call;
+
+    if (uart1Count == 0) {
+        return reg.value;
+    }
+
+    uint8_t byte = uart1Fifo[0];
+    uart1Fifo[0] = uart1Fifo[1];
+    uart1Count--;
+    uart1Overrun = false;
+
+    if (uart1ShiftFull) {
+        uart1Fifo[uart1Count++] = uart1Shift;
+        uart1ShiftFull = false;
+    }
+
+    const_cast<HostRegister8&>(reg).value = byte;
+    return byte;
+}
+
+/**
+ * @brief Sends a byte to the module: the transmitter is always ready, the byte is only recorded.
+ */
+static void writeUdr1(HostRegister8&, uint8_t value) {
+    bluetoothSent.push_back(value);
+}
+
+void hostBluetoothReceive(const uint8_t* data, size_t length) {
+    HostCall call;
+    const uint64_t byteTime = 10 * 1000000000000ULL / HOST_BT_BAUD;
+    uint64_t arrival = max(now, bluetoothLastArrival);
+
+    for (size_t i = 0; i < length; i++) {
+        arrival += byteTime;
+        bluetoothQueue.push_back({ arrival, data[i] });
+    }
+
+    bluetoothLastArrival = arrival;
+}
+
+const std::string& hostBluetoothSent() {
+    return bluetoothSent;
+}
+
+//-----------------------------------------------------------------------------
+// USART0: USB serial port
+//-----------------------------------------------------------------------------
+
+/**
+ * @brief Gets the transmission time of a byte at the configured baud rate (ps), 0 before begin().
+ */
+static uint64_t serialByteTime() {
+    return serialBaud ? 10 * 1000000000000ULL / serialBaud : 0;
+}
+
+/**
+ * @brief Gets the number of bytes not completely sent yet.
+ */
+static unsigned serialPending() {
+    uint64_t byteTime = serialByteTime();
+
+    if (byteTime == 0 || serialTxEnd <= now) {
+        return 0;
+    }
+
+    return (serialTxEnd - now + byteTime - 1) / byteTime;
+}
+
+void HardwareSerial::begin(unsigned long baud, uint8_t) {
+    HostCall call;
+    serialBaud = baud;
+}
+
+void HardwareSerial::end() {
+    HostCall call;
+    flush();
+    serialBaud = 0;
+}
+
+int HardwareSerial::available() {
+    HostCall call;
+    return serialInput.size();
+}
+
+int HardwareSerial::read() {
+    HostCall call;
+
+    if (serialInput.empty()) {
+        return -1;
+    }
+
+    uint8_t character = serialInput.front();
+    serialInput.pop_front();
+    return character;
+}
+
+int HardwareSerial::peek() {
+    HostCall call;
+    return serialInput.empty() ? -1 : serialInput.front();
+}
+
+int HardwareSerial::availableForWrite() {
+    HostCall call;
+    unsigned pending = serialPending();
+
+    // The byte being shifted out has left the buffer
+    unsigned used = pending > 0 ? pending - 1 : 0;
+    return (used < SERIAL_TX_BUFFER_SIZE - 1) ? SERIAL_TX_BUFFER_SIZE - 1 - used : 0;
+}
+
+void HardwareSerial::flush() {
+    HostCall call;
+
+    if (serialTxEnd > now) {
+        hostAdvance((serialTxEnd - now + 999999) / 1000000);
+    }
+}
+
+/**
+ * @brief Queues a byte, waiting for room in the transmit buffer.
+ */
+size_t HardwareSerial::write(uint8_t byte) {
+    HostCall call;
+    uint64_t byteTime = serialByteTime();
+
+    if (byteTime != 0) {
+        while (availableForWrite() == 0) {
+            hostAdvance(max(1ULL, byteTime / 1000000));
+        }
+        serialTxEnd = max(serialTxEnd, now) + byteTime;
+    }
+
+    serialOutput.push_back(byte);
+
+    if (serialEcho) {
+        putchar(byte);
+    }
+
+    return 1;
+}
+
+void hostSerialReceive(const char* text) {
+    while (*text) {
+        serialInput.push_back(*text++);
+    }
+}
+
+const std::string& hostSerialOutput() {
+    return serialOutput;
+}
+
+void hostSerialEcho(bool echo) {
+    fflush(stdout);
+    serialEcho = echo;
+}
+
+//-----------------------------------------------------------------------------
+// LED strip
+//-----------------------------------------------------------------------------
+
+/**
+ * @brief Latches the received colors once the data line has been idle for the reset time.
+ */
+static void latchStrip() {
+    if (stripData.empty() || now - stripLastData < microsToPs(HOST_STRIP_RESET_TIME)) {
+        return;
+    }
+
+    // The pixels after the received ones keep their colors
+    if (stripData.size() < stripBytes) {
+        stripStats.partialFrames++;
+    }
+
+    stripFrame.replace(0, min(stripData.size(), stripFrame.size()), stripData, 0, min(stripData.size(), stripFrame.size()));
+    stripStats.latchedFrames++;
+    stripData.clear();
+}
+
+void hostStripBegin(uint16_t bytes) {
+    stripBytes = bytes;
+    stripFrame.assign(bytes, '\0');
+}
+
+void hostStripReceive(const uint8_t* data, uint16_t length) {
+    HostCall call;
+
+    latchStrip();
+
+    // Bytes past the end of the strip are passed on by the last pixel, and lost
+    stripData.append((const char*)data, min((size_t)length, stripBytes - min((size_t)stripBytes, stripData.size())));
+    stripStats.bytesReceived += length;
+
+    // 8 bits of 1.25 µs per byte
+    hostAdvance(10UL * length);
+    stripLastData = now;
+}
+
+hostStripStats_t hostStripStats() {
+    latchStrip();
+    return stripStats;
+}
+
+const std::string& hostStripFrame() {
+    latchStrip();
+    return stripFrame;
+}
+
+//-----------------------------------------------------------------------------
+// Heap
+//-----------------------------------------------------------------------------
+
+extern "C" {
+
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* pointer, size_t size);
+void __real_free(void* pointer);
+
+void* __wrap_malloc(size_t size) {
+    void* pointer = __real_malloc(size);
+
+    heapUsed += malloc_usable_size(pointer);
+    return pointer;
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    void* pointer = __real_calloc(count, size);
+
+    heapUsed += malloc_usable_size(pointer);
+    return pointer;
+}
+
+void* __wrap_realloc(void* pointer, size_t size) {
+    size_t previous = malloc_usable_size(pointer);
+    void* resized = __real_realloc(pointer, size);
+
+    // A failed realloc() keeps the previous block
+    if (resized != NULL || size == 0) {
+        heapUsed += malloc_usable_size(resized) - previous;
+    }
+    return resized;
+}
+
+void __wrap_free(void* pointer) {
+    heapUsed -= malloc_usable_size(pointer);
+    __real_free(pointer);
+}
+
+}
+
+size_t hostHeapUsed() {
+    return heapUsed;
+}
+
+//-----------------------------------------------------------------------------
+// Virtual time
+//-----------------------------------------------------------------------------
+
+/**
+ * @brief Gets the time of the next peripheral event.
+ */
+static uint64_t nextEvent() {
+    uint64_t next = bluetoothQueue.empty() ? NEVER : bluetoothQueue.front().time;
+    next = min(next, timer1Match);
+    next = min(next, timer5Overflow);
+    next = min(next, adcDone);
+    return next;
+}
+
+/**
+ * @brief Advances the virtual time to the given time, handling the peripheral events on the way.
+ */
+static void advanceTo(uint64_t target) {
+    for (;;) {
+        uint64_t next = nextEvent();
+
+        if (next > target) {
+            break;
+        }
+
+        now = max(now, next);
+
+        while (!bluetoothQueue.empty() && bluetoothQueue.front().time <= now) {
+            receiveUart1(bluetoothQueue.front().byte);
+            bluetoothQueue.pop_front();
+        }
+
+        if (timer1Match <= now) {
+            matchTimer1();
+        }
+
+        if (timer5Overflow <= now) {
+            overflowTimer5();
+        }
+
+        if (adcDone <= now) {
+            completeAdcConversion();
+        }
+
+        hostServiceInterrupts();
+    }
+
+    now = max(now, target);
+}
+
+uint64_t hostTime() {
+    return now / 1000;
+}
+
+void hostAdvance(unsigned long us) {
+    advanceTo(now + microsToPs(us));
+}
+
+/**
+ * @brief Idles until the next interrupt, the Timer0 overflow of the Arduino core waking the CPU at least every 1024 µs.
+ */
+void hostSleep() {
+    HostCall call;
+    uint64_t overflow = (now / TIMER0_OVERFLOW_PS + 1) * TIMER0_OVERFLOW_PS;
+    advanceTo(min(nextEvent(), overflow));
+}
+
+void hostRunFor(unsigned long ms) {
+    uint64_t end = now + microsToPs(1000ULL * ms);
+
+    while (now < end) {
+        hostRunFirmware(loop);
+    }
+}
+
+/**
+ * @brief Initializes the board as the Arduino core does before setup(): the interrupts are enabled.
+ */
+void init() {
+    SREG = _BV(SREG_I);
+
+    for (uint8_t i = 0; i < PORT_COUNT; i++) {
+        updatePort(i);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Default interrupt vectors
+//-----------------------------------------------------------------------------
+
+#define HOST_DEFAULT_VECTOR(vector) extern "C" __attribute__((weak)) void vector(void) {}
+
+HOST_DEFAULT_VECTOR(INT0_vect)
+HOST_DEFAULT_VECTOR(INT1_vect)
+HOST_DEFAULT_VECTOR(INT2_vect)
+HOST_DEFAULT_VECTOR(INT3_vect)
+HOST_DEFAULT_VECTOR(INT4_vect)
+HOST_DEFAULT_VECTOR(INT5_vect)
+HOST_DEFAULT_VECTOR(INT6_vect)
+HOST_DEFAULT_VECTOR(INT7_vect)
+HOST_DEFAULT_VECTOR(TIMER1_COMPA_vect)
+HOST_DEFAULT_VECTOR(ADC_vect)
+HOST_DEFAULT_VECTOR(USART1_RX_vect)
+HOST_DEFAULT_VECTOR(TIMER5_OVF_vect)
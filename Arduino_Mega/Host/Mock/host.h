@@ -0,0 +1,223 @@
+/**
+* @file host.h
+* @brief Control of the host simulation of the robot.
+* @details The firmware runs unchanged on the computer against the mock HAL of this directory. Time is virtual, in
+*          nanoseconds: it advances when the firmware waits (delay(), sleep, serial or LED strip transmission), by the
+*          execution time of the firmware on the host CPU (see hostSetCpuScale()), and when the scenario runs the firmware
+*          with hostRunFor(). The peripherals raise
+*          their interrupts at their simulated time: received Bluetooth bytes (USART1, with its 2-byte FIFO and data overrun),
+*          tone engine compare matches (Timer1), ADC conversions and external interrupts. Interrupts are only serviced while
+*          the I flag of SREG is set, so an interrupt-disabled section delays them exactly as on the robot.
+*/
+
+#pragma once
+
+//=============================================================================
+//                       INCLUDE LIBRARIES AND HEADER FILES
+//=============================================================================
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include <string>
+
+//=============================================================================
+//                              TYPE DECLARATIONS
+//=============================================================================
+
+/**
+ * @brief Statistics of the simulated LED strip.
+ */
+typedef struct hostStripStats_t {
+    unsigned long latchedFrames;   /**< Frames displayed by the strip, latched after a reset time without data */
+    unsigned long partialFrames;   /**< Latched frames shorter than the strip, e.g. cut by a too long pause between two segments */
+    unsigned long bytesReceived;   /**< Color bytes received */
+} hostStripStats_t;
+
+/**
+ * @brief Marks a call from the firmware to the simulation, for the lifetime of the object.
+ * @details On entry, the virtual time advances by the execution time of the firmware since it last called the
+ *          simulation. The time spent until the exit, in the simulation, is not counted. Declared at the start of every
+ *          routine of the mock called by the firmware.
+ */
+class HostCall {
+    public:
+        HostCall();
+        ~HostCall();
+
+        HostCall(const HostCall&) = delete;
+        HostCall& operator=(const HostCall&) = delete;
+};
+
+//=============================================================================
+//                                   MACROS
+//=============================================================================
+
+/**
+ * @brief Baud rate the simulated Bluetooth module sends at.
+ */
+#define HOST_BT_BAUD 57600
+
+/**
+ * @brief Reset time after which the simulated strip latches the received colors (µs), as the SK6812.
+ */
+#define HOST_STRIP_RESET_TIME 80
+
+//=============================================================================
+//                           ROUTINE PROTOTYPES
+//=============================================================================
+
+/**
+ * @brief Gets the virtual time.
+ * @return Time since the start of the simulation (ns).
+ */
+extern uint64_t hostTime();
+
+/**
+ * @brief Advances the virtual time, raising the interrupts of the peripherals on the way.
+ * @param us Duration (µs).
+ */
+extern void hostAdvance(unsigned long us);
+
+/**
+ * @brief Runs loop() until the virtual time has advanced by the given duration.
+ * @param ms Duration (ms).
+ */
+extern void hostRunFor(unsigned long ms);
+
+/**
+ * @brief Runs code of the firmware (setup(), loop() or an interrupt routine), counting its execution time.
+ * @param code Routine to run.
+ */
+extern void hostRunFirmware(void (*code)(void));
+
+/**
+ * @brief Sets the factor applied to the execution time of the firmware on the host CPU.
+ * @details 1 by default: the firmware runs at the speed of the host, much faster than on the ATmega2560. A larger factor
+ *          brings the loads closer to the robot, but the durations stay host measurements: they vary from run to run and
+ *          do not model the cost of the AVR instructions.
+ * @param scale Factor, 0 for an infinitely fast CPU.
+ */
+extern void hostSetCpuScale(double scale);
+
+/**
+ * @brief Services the pending interrupts if the I flag of SREG is set.
+ */
+extern void hostServiceInterrupts();
+
+/**
+ * @brief Gets the longest time the interrupts were disabled since the last call.
+ * @return Duration (µs).
+ */
+extern unsigned long hostMaxInterruptsOff();
+
+/**
+ * @brief Queues bytes sent by the Bluetooth module to USART1, received one after the other at HOST_BT_BAUD.
+ * @param data Bytes to send.
+ * @param length Number of bytes.
+ */
+extern void hostBluetoothReceive(const uint8_t* data, size_t length);
+
+/**
+ * @brief Gets the bytes sent by the firmware to the Bluetooth module.
+ */
+extern const std::string& hostBluetoothSent();
+
+/**
+ * @brief Queues characters received on the USB serial port, readable right away.
+ * @param text Characters to receive.
+ */
+extern void hostSerialReceive(const char* text);
+
+/**
+ * @brief Gets the characters sent on the USB serial port since the start of the simulation.
+ */
+extern const std::string& hostSerialOutput();
+
+/**
+ * @brief Stops copying the USB serial output to the standard output, e.g. while a scenario prints its report.
+ * @param echo True to copy the output, the default.
+ */
+extern void hostSerialEcho(bool echo);
+
+/**
+ * @brief Drives an input pin from outside the board, raising the external interrupt of the pin if any.
+ * @param pin Arduino pin number.
+ * @param level HIGH or LOW.
+ */
+extern void hostSetPin(uint8_t pin, uint8_t level);
+
+/**
+ * @brief Releases a pin driven by hostSetPin(): it reads its pull-up again.
+ * @param pin Arduino pin number.
+ */
+extern void hostReleasePin(uint8_t pin);
+
+/**
+ * @brief Gets the level of a pin.
+ * @param pin Arduino pin number.
+ * @return HIGH or LOW.
+ */
+extern uint8_t hostGetPin(uint8_t pin);
+
+/**
+ * @brief Gets the number of level changes of a pin since the start of the simulation.
+ * @param pin Arduino pin number.
+ */
+extern unsigned long hostPinToggles(uint8_t pin);
+
+/**
+ * @brief Sets the voltage of an analog input.
+ * @param channel ADC channel (0 for A0).
+ * @param value Value converted by the ADC, 0 to 1023.
+ */
+extern void hostSetAnalog(uint8_t channel, uint16_t value);
+
+/**
+ * @brief Gets the last value given to analogWrite() for a pin.
+ */
+extern int hostAnalogOutput(uint8_t pin);
+
+/**
+ * @brief Gets the time a duty cycle of the motor PWM outputs (OCR2A for EN_A, OCR3A for EN_B) last changed.
+ * @return Virtual time (ns).
+ */
+extern uint64_t hostMotorPwmChangeTime();
+
+/**
+ * @brief Gets the memory allocated on the heap by the firmware and not freed yet.
+ * @details The usable sizes of the blocks given by the allocator of the host, larger than on the ATmega2560.
+ * @return Size (bytes).
+ */
+extern size_t hostHeapUsed();
+
+/**
+ * @brief Gets the frequency played by tone() on a pin.
+ * @return Frequency (Hz), 0 if silent.
+ */
+extern unsigned int hostToneFrequency(uint8_t pin);
+
+/**
+ * @brief Receives color bytes on the data pin of the LED strip, called by the Adafruit_NeoPixel mock.
+ * @details Takes 10 µs per byte (800 kHz) of virtual time. Data received after HOST_STRIP_RESET_TIME without data
+ *          starts a new frame, at the first pixel.
+ * @param data Color bytes.
+ * @param length Number of bytes.
+ */
+extern void hostStripReceive(const uint8_t* data, uint16_t length);
+
+/**
+ * @brief Sets the length of the simulated strip, called by the Adafruit_NeoPixel mock.
+ * @param bytes Number of color bytes of a whole frame.
+ */
+extern void hostStripBegin(uint16_t bytes);
+
+/**
+ * @brief Gets the statistics of the simulated strip.
+ */
+extern hostStripStats_t hostStripStats();
+
+/**
+ * @brief Gets the colors displayed by the simulated strip, as sent (GRB order).
+ */
+extern const std::string& hostStripFrame();
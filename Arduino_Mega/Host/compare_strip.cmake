@@ -0,0 +1,31 @@
+# Runs the strip scenario with the standard and the chunked LED strip drivers, under the same Bluetooth load, and prints
+# their reports side by side. Fails if either scenario fails: the standard driver must lose received bytes, the chunked
+# driver none.
+#
+#     cmake -DSTANDARD=<discobot_host> -DCHUNKED=<discobot_host_chunked> -P compare_strip.cmake
+
+set(failed "")
+set(reports "")
+
+foreach(driver STANDARD CHUNKED)
+    execute_process(COMMAND ${${driver}} strip
+        OUTPUT_QUIET
+        ERROR_VARIABLE checks
+        RESULT_VARIABLE result)
+
+    # Checks of the scenario, on the standard error: the report line, then the checks that failed
+    string(REGEX MATCH "strip [a-z]+ *: [^\n]*" report "${checks}")
+    string(REGEX MATCHALL "sim: FAIL [^\n]*" failures "${checks}")
+    string(APPEND reports "  ${report}\n")
+
+    if(NOT result EQUAL 0)
+        string(REPLACE ";" "\n  " failures "${failures}")
+        string(APPEND failed "${${driver}}:\n  ${failures}\n")
+    endif()
+endforeach()
+
+message("${reports}")
+
+if(NOT failed STREQUAL "")
+    message(FATAL_ERROR "${failed}")
+endif()
@@ -0,0 +1,129 @@
+/**
+* @file remote.cpp
+* @brief TI remote of the host simulation: the TI_MSP432P401R sketch run next to the robot firmware.
+* @details The sketch is included in the remote namespace, after the parts of the Energia API it uses: millis(),
+*          analogRead(), digitalRead(), pinMode() and the Serial (USB) and Serial1 (HC-05) ports.
+*/
+
+//=============================================================================
+//                       INCLUDE LIBRARIES AND HEADER FILES
+//=============================================================================
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "Mock/host.h"
+#include "remote.h"
+
+//=============================================================================
+//                              ENERGIA API OF THE REMOTE
+//=============================================================================
+
+namespace remote {
+
+#define HIGH 0x1
+#define LOW 0x0
+#define INPUT_PULLUP 0x2
+
+/**
+ * @brief Number of pins of the MSP432 LaunchPad with its BoosterPack headers.
+ */
+#define REMOTE_PIN_COUNT 41
+
+/**
+ * @brief Values converted by the ADC on each pin, levels of the digital inputs, and time of the last conversion (ns).
+ */
+static uint16_t analogInputs[REMOTE_PIN_COUNT];
+static uint8_t digitalInputs[REMOTE_PIN_COUNT];
+static uint64_t sampleTime = 0;
+
+/**
+ * @brief Characters printed on the USB serial port.
+ */
+static std::string serialOutput;
+
+unsigned long millis() {
+    return hostTime() / 1000000;
+}
+
+void pinMode(uint8_t pin, uint8_t mode) {
+    if (pin < REMOTE_PIN_COUNT && mode == INPUT_PULLUP) {
+        digitalInputs[pin] = HIGH;
+    }
+}
+
+int digitalRead(uint8_t pin) {
+    return pin < REMOTE_PIN_COUNT ? digitalInputs[pin] : LOW;
+}
+
+int analogRead(uint8_t pin) {
+    sampleTime = hostTime();
+    return pin < REMOTE_PIN_COUNT ? analogInputs[pin] : 0;
+}
+
+/**
+ * @brief USB serial port of the remote, recorded as text.
+ */
+class RemoteSerial {
+    public:
+        void begin(unsigned long) {}
+        void write(const char* text) { serialOutput += text; }
+        void print(const char* text) { serialOutput += text; }
+        void print(unsigned long number) { serialOutput += std::to_string(number); }
+        void println(const char* text) { serialOutput += text; serialOutput += "\r\n"; }
+};
+
+/**
+ * @brief Serial port wired to the HC-05: the bytes are received by USART1 of the robot.
+ */
+class RemoteBluetooth {
+    public:
+        void begin(unsigned long) {}
+        void write(const uint8_t* data, size_t length) { hostBluetoothReceive(data, length); }
+};
+
+static RemoteSerial Serial;
+static RemoteBluetooth Serial1;
+
+//=============================================================================
+//                                   SKETCH
+//=============================================================================
+
+#include "../../TI_MSP432P401R/TI_MSP432P401R.ino"
+
+} // namespace remote
+
+//=============================================================================
+//                              ROUTINE DEFINITIONS
+//=============================================================================
+
+void remoteBegin() {
+    // Stick at rest, button released
+    remoteSetJoystick(512, 512);
+    remoteSetSelect(false);
+    remote::setup();
+}
+
+void remoteRunFor(unsigned long ms) {
+    for (unsigned long elapsed = 0; elapsed < ms; elapsed++) {
+        remote::loop();
+        hostRunFor(1);
+    }
+}
+
+void remoteSetJoystick(uint16_t x, uint16_t y) {
+    remote::analogInputs[JOYSTICK_X] = x;
+    remote::analogInputs[JOYSTICK_Y] = y;
+}
+
+void remoteSetSelect(bool pressed) {
+    remote::digitalInputs[JOYSTICK_SEL] = pressed ? LOW : HIGH;
+}
+
+uint64_t remoteSampleTime() {
+    return remote::sampleTime;
+}
+
+const std::string& remoteSerialOutput() {
+    return remote::serialOutput;
+}
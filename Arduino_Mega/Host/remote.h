@@ -0,0 +1,59 @@
+/**
+* @file remote.h
+* @brief TI remote of the host simulation: the TI_MSP432P401R sketch run next to the robot firmware.
+* @details The sketch is built unchanged against a small mock of the Energia API of the MSP432 board. Both boards share
+*          the virtual time of host.h: the loop of the remote runs every millisecond, the robot runs in between. The bytes
+*          the remote writes to Serial1 go through its HC-05 to USART1 of the robot, serialized at HOST_BT_BAUD; the
+*          delay of the radio link itself is not modelled. The execution time of the remote is not counted, the MSP432
+*          only samples and sends a few bytes every SAMPLE_PERIOD_MS.
+*/
+
+#pragma once
+
+//=============================================================================
+//                       INCLUDE LIBRARIES AND HEADER FILES
+//=============================================================================
+
+#include <stdint.h>
+
+#include <string>
+
+//=============================================================================
+//                           ROUTINE PROTOTYPES
+//=============================================================================
+
+/**
+ * @brief Runs setup() of the remote.
+ */
+extern void remoteBegin();
+
+/**
+ * @brief Runs both boards: the loop of the remote every millisecond, the loop of the robot in between.
+ * @param ms Duration (ms).
+ */
+extern void remoteRunFor(unsigned long ms);
+
+/**
+ * @brief Moves the joystick of the remote.
+ * @details The sketch swaps the axes: the Y axis of the remote stick is the X axis of the robot (forward / backward).
+ * @param x ADC value of the X axis of the stick, 0 to 1023.
+ * @param y ADC value of the Y axis of the stick, 0 to 1023.
+ */
+extern void remoteSetJoystick(uint16_t x, uint16_t y);
+
+/**
+ * @brief Presses or releases the select button of the joystick (active low).
+ * @param pressed True while the button is held.
+ */
+extern void remoteSetSelect(bool pressed);
+
+/**
+ * @brief Gets the time the remote last sampled its joystick with its ADC.
+ * @return Virtual time (ns).
+ */
+extern uint64_t remoteSampleTime();
+
+/**
+ * @brief Gets the characters printed by the remote on its USB serial port.
+ */
+extern const std::string& remoteSerialOutput();
@@ -0,0 +1,813 @@
+/**
+* @file simulation.cpp
+* @brief Scenarios of the host simulation of the robot.
+* @details Runs the firmware (setup() then loop()) against the mock HAL, plays the part of the remote (or runs its sketch,
+*          see remote.h), the smartphone, the USB serial console and the hardware joystick, and checks the motor outputs, the buzzer, the LED strip and the statistics
+*          printed by the firmware. The USB serial output of the firmware is copied as is to the standard output, the checks
+*          are reported on the standard error: "discobot_host drive > capture.bin" gives a capture for Tools/decode_log.py.
+*
+* Usage:
+*     discobot_host [--cpu-scale <factor>] <scenario> [<argument>]
+*/
+
+//=============================================================================
+//                       INCLUDE LIBRARIES AND HEADER FILES
+//=============================================================================
+
+#include <stdarg.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "Mock/host.h"
+#include "remote.h"
+
+#include "../Inc/utils.h"
+#include "../Inc/bluetooth.h"
+#include "../Inc/buzzer.h"
+#include "../Inc/joystick.h"
+#include "../Inc/motor.h"
+#include "../Inc/profiler.h"
+
+//=============================================================================
+//                              TYPE DECLARATIONS
+//=============================================================================
+
+/**
+ * @brief Scenario: name and routine, returning true if all its checks passed.
+ */
+typedef struct scenario_t {
+    const char* name;
+    bool (*run)();
+} scenario_t;
+
+//=============================================================================
+//                                   MACROS
+//=============================================================================
+
+/**
+ * @brief Period the TI remote sends its frames at when the joystick moves (ms).
+ */
+#define REMOTE_PERIOD 10
+
+/**
+ * @brief Joystick byte of the remote at rest, decoded as 0 by the robot.
+ */
+#define REMOTE_CENTER 128
+
+/**
+ * @brief Motor direction pins of PORTH (IN_1 to IN_4).
+ */
+#define MOTOR_DIRECTION_MASK (_BV(PH3) | _BV(PH4) | _BV(PH5) | _BV(PH6))
+
+/**
+ * @brief ADC values of the remote stick at rest and pushed forward (Y axis of the stick).
+ */
+#define STICK_CENTER 512
+#define STICK_FORWARD 800
+
+/**
+ * @brief Number of stick moves measured per load, and time the stick is held after each move (ms).
+ * @details The hold time lets the motor ramp settle, so that the first PWM change after a move is caused by the move.
+ */
+#define LATENCY_STEPS 100
+#define LATENCY_HOLD 300
+
+/**
+ * @brief Highest acceptable 99th percentile of the latency from the ADC sample of the remote to the motor PWM change (µs).
+ * @details The robot part is checked against PROFILE_LATENCY_LIMIT, the transfer of a 6-byte frame at 57600 bauds adds about 1 ms.
+ */
+#define LATENCY_LIMIT (PROFILE_LATENCY_LIMIT + 2000)
+
+/**
+ * @brief Duration of the Bluetooth load of the strip scenario (ms).
+ */
+#define STRIP_LOAD_TIME 5000
+
+//=============================================================================
+//                             VARIABLE DEFINITIONS
+//=============================================================================
+
+/**
+ * @brief Sequence number of the next frame of the remote.
+ */
+static uint8_t remoteSequence = 0;
+
+/**
+ * @brief Argument of the scenario given on the command line, NULL if none.
+ */
+static const char* scenarioArgument = NULL;
+
+//=============================================================================
+//                              ROUTINE DEFINITIONS
+//=============================================================================
+
+//-----------------------------------------------------------------------------
+// Helpers
+//-----------------------------------------------------------------------------
+
+/**
+ * @brief Reports a check on the standard error.
+ * @return The condition.
+ */
+static bool check(bool condition, const char* format, ...) {
+    va_list arguments;
+
+    fprintf(stderr, "sim: %s ", condition ? "ok  " : "FAIL");
+    va_start(arguments, format);
+    vfprintf(stderr, format, arguments);
+    va_end(arguments);
+    fputc('\n', stderr);
+
+    return condition;
+}
+
+/**
+ * @brief CRC-8 of the TI remote, written independently of crc8() so that both are checked against each other.
+ */
+static uint8_t remoteCrc8(const uint8_t* data, uint8_t length) {
+    uint8_t crc = 0;
+
+    while (length--) {
+        crc ^= *data++;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (crc << 1) ^ 0x07 : crc << 1;
+        }
+    }
+
+    return crc;
+}
+
+/**
+ * @brief Sends a binary frame from the TI remote.
+ * @param type Message type (BT_MSG_JOYSTICK or BT_MSG_MODE).
+ * @param x Joystick X byte.
+ * @param y Joystick Y byte.
+ * @param withSync False to drop the sync byte, as when it is lost on the link.
+ */
+static void sendRemoteFrame(uint8_t type, uint8_t x, uint8_t y, bool withSync = true) {
+    uint8_t frame[BT_BINARY_FRAME_SIZE] = { BT_SYNC, type, x, y, remoteSequence++, 0 };
+
+    frame[BT_BINARY_FRAME_SIZE - 1] = remoteCrc8(frame + 1, BT_BINARY_FRAME_SIZE - 2);
+    hostBluetoothReceive(withSync ? frame : frame + 1, withSync ? BT_BINARY_FRAME_SIZE : BT_BINARY_FRAME_SIZE - 1);
+}
+
+/**
+ * @brief Holds the joystick of the TI remote, which sends a frame every REMOTE_PERIOD.
+ */
+static void holdRemote(uint8_t x, uint8_t y, unsigned long ms) {
+    for (unsigned long elapsed = 0; elapsed < ms; elapsed += REMOTE_PERIOD) {
+        sendRemoteFrame(BT_MSG_JOYSTICK, x, y);
+        hostRunFor(REMOTE_PERIOD);
+    }
+}
+
+/**
+ * @brief Sends text from a smartphone.
+ */
+static void sendPhone(const char* text) {
+    hostBluetoothReceive((const uint8_t*)text, strlen(text));
+}
+
+/**
+ * @brief Switches to the given mode with mode messages of the remote.
+ */
+static void selectMode(int target) {
+    for (uint8_t i = 0; i < ledPatternCount && mode != target; i++) {
+        sendRemoteFrame(BT_MSG_MODE, 0, 0);
+        hostRunFor(REMOTE_PERIOD);
+    }
+}
+
+static uint8_t speedLeft() {
+    return OCR3A;
+}
+
+static uint8_t speedRight() {
+    return OCR2A;
+}
+
+static uint8_t motorDirections() {
+    return PORTH & MOTOR_DIRECTION_MASK;
+}
+
+/**
+ * @brief Sends a request on the USB serial console and gets the text printed in response.
+ */
+static std::string requestConsole(const char* request) {
+    size_t start = hostSerialOutput().size();
+
+    hostSerialReceive(request);
+    hostRunFor(200);
+
+    return hostSerialOutput().substr(start);
+}
+
+/**
+ * @brief Gets the line of a text starting with the given prefix, empty if none.
+ */
+static std::string findLine(const std::string& text, const char* prefix) {
+    size_t start = text.find(prefix);
+
+    if (start == std::string::npos) {
+        return std::string();
+    }
+
+    return text.substr(start, text.find('\n', start) - start);
+}
+
+//-----------------------------------------------------------------------------
+// Scenarios
+//-----------------------------------------------------------------------------
+
+/**
+ * @brief Boots and idles: the motors stay off and the LED strip displays the first mode.
+ */
+static bool scenarioBoot() {
+    bool passed = true;
+
+    hostRunFor(1000);
+
+    hostStripStats_t strip = hostStripStats();
+    std::string frame = hostStripFrame();
+
+    passed &= check(speedLeft() == 0 && speedRight() == 0, "motors off at rest (PWM %u, %u)", speedLeft(), speedRight());
+    passed &= check(strip.latchedFrames >= 1 && strip.partialFrames == 0, "LED frames latched %lu, partial %lu", strip.latchedFrames, strip.partialFrames);
+    passed &= check(frame.find_first_not_of('\0') != std::string::npos, "LED strip lit");
+
+    return passed;
+}
+
+/**
+ * @brief Drives with the TI remote: forward, backward, turn, rest, then the failsafe stop when the remote goes silent.
+ */
+static bool scenarioDrive() {
+    bool passed = true;
+
+    holdRemote(REMOTE_CENTER, 255, 1000);
+    uint8_t forward = motorDirections();
+    passed &= check(speedLeft() > 0 && speedRight() > 0, "full Y: both motors run (PWM %u, %u)", speedLeft(), speedRight());
+
+    holdRemote(REMOTE_CENTER, 0, 1000);
+    uint8_t backward = motorDirections();
+    passed &= check(speedLeft() > 0 && speedRight() > 0 && backward != forward,
+                    "zero Y: both motors run the other way (PWM %u, %u, directions %02X then %02X)", speedLeft(), speedRight(), forward, backward);
+
+    holdRemote(255, REMOTE_CENTER, 1000);
+    passed &= check(speedLeft() != speedRight() || motorDirections() != forward,
+                    "full X: the robot turns (PWM %u, %u, directions %02X)", speedLeft(), speedRight(), motorDirections());
+
+    holdRemote(REMOTE_CENTER, REMOTE_CENTER, 1000);
+    passed &= check(speedLeft() == 0 && speedRight() == 0, "joystick at rest: motors off (PWM %u, %u)", speedLeft(), speedRight());
+
+    holdRemote(REMOTE_CENTER, 255, 1000);
+    hostRunFor(BT_COMMAND_TIMEOUT - 100);
+    passed &= check(speedLeft() > 0 && speedRight() > 0, "remote silent for less than BT_COMMAND_TIMEOUT: motors still run");
+
+    hostRunFor(1000);
+    passed &= check(speedLeft() == 0 && speedRight() == 0, "remote silent: failsafe stop (PWM %u, %u)", speedLeft(), speedRight());
+    passed &= check(btLinkStats.timeouts == 1, "timeouts %u", btLinkStats.timeouts);
+    passed &= check(btLinkStats.droppedFrames == 0 && btLinkStats.malformedFrames == 0,
+                    "valid frames %u, malformed %u, dropped %u", btLinkStats.validFrames, btLinkStats.malformedFrames, btLinkStats.droppedFrames);
+
+    return passed;
+}
+
+/**
+ * @brief Loses the sync byte of a binary frame whose payload holds pad commands: they must not move the robot.
+ */
+static bool scenarioLostSync() {
+    bool passed = true;
+
+    holdRemote(REMOTE_CENTER, REMOTE_CENTER, 200);
+
+    // 'A' (turn) and 'M' (mode) as X and Y bytes, for less than BT_COMMAND_TIMEOUT: the link is still active
+    for (unsigned long elapsed = 0; elapsed < BT_COMMAND_TIMEOUT / 2; elapsed += REMOTE_PERIOD) {
+        sendRemoteFrame(BT_MSG_JOYSTICK, 'A', 'M', false);
+        hostRunFor(REMOTE_PERIOD);
+        passed &= (speedLeft() == 0 && speedRight() == 0);
+    }
+
+    holdRemote(REMOTE_CENTER, REMOTE_CENTER, 200);
+
+    passed &= check(passed, "motors stay off (PWM %u, %u)", speedLeft(), speedRight());
+    passed &= check(mode == 0, "mode unchanged (%d)", mode);
+    passed &= check(btLinkStats.malformedFrames > 0, "payload bytes counted as malformed (%u)", btLinkStats.malformedFrames);
+
+    return passed;
+}
+
+/**
+ * @brief Drives with a smartphone: ASCII joystick frames and pad commands.
+ */
+static bool scenarioPhone() {
+    bool passed = true;
+
+    for (uint8_t i = 0; i < 100; i++) {
+        sendPhone("*X128,Y255_");
+        hostRunFor(REMOTE_PERIOD);
+    }
+    uint8_t forward = motorDirections();
+    passed &= check(speedLeft() > 0 && speedRight() > 0, "ASCII frames: both motors run (PWM %u, %u)", speedLeft(), speedRight());
+
+    for (uint8_t i = 0; i < 100; i++) {
+        sendPhone("G");
+        hostRunFor(REMOTE_PERIOD);
+    }
+    passed &= check(speedLeft() > 0 && speedRight() > 0 && motorDirections() != forward,
+                    "backward pad command: both motors run the other way (PWM %u, %u)", speedLeft(), speedRight());
+
+    for (uint8_t i = 0; i < 100; i++) {
+        sendPhone("*X128,Y128_");
+        hostRunFor(REMOTE_PERIOD);
+    }
+    passed &= check(speedLeft() == 0 && speedRight() == 0, "ASCII frames at rest: motors off (PWM %u, %u)", speedLeft(), speedRight());
+
+    sendPhone("M");
+    hostRunFor(100);
+    passed &= check(mode == 1, "mode command: mode %d", mode);
+
+    // Out of range value, then truncated frame
+    sendPhone("*X999,Y1_*X12*X128,Y128_");
+    hostRunFor(100);
+    passed &= check(btLinkStats.malformedFrames == 2, "malformed frames %u", btLinkStats.malformedFrames);
+
+    return passed;
+}
+
+/**
+ * @brief Plays the music of the first mode, then switches to the mode without music.
+ */
+static bool scenarioMusic() {
+    bool passed = true;
+
+    hostRunFor(3000);
+    unsigned long toggles = hostPinToggles(BUZZER_PIN);
+
+    // Between the lowest and the highest note of pitches.h, 2 toggles per period
+    passed &= check(toggles > 2 * NOTE_B0 && toggles < 3 * 2 * NOTE_DS8, "buzzer toggles in 3 s: %lu", toggles);
+
+    selectMode(ledPatternCount - 1);
+    passed &= check(mode == ledPatternCount - 1, "last mode selected (%d)", mode);
+
+    hostRunFor(100);
+    toggles = hostPinToggles(BUZZER_PIN);
+    hostRunFor(2000);
+
+    passed &= check(hostPinToggles(BUZZER_PIN) == toggles, "no music in the last mode (%lu toggles)", hostPinToggles(BUZZER_PIN) - toggles);
+    passed &= check(hostGetPin(BUZZER_PIN) == LOW, "buzzer pin left low");
+
+    return passed;
+}
+
+/**
+ * @brief Presses the joystick switch, with bounces: one mode change per press.
+ */
+static bool scenarioSwitch() {
+    bool passed = true;
+
+    hostRunFor(500);
+
+    for (uint8_t press = 0; press < 3; press++) {
+        // Bouncing press, held, then bouncing release
+        for (uint8_t bounce = 0; bounce < 3; bounce++) {
+            hostSetPin(SW, LOW);
+            hostAdvance(300);
+            hostSetPin(SW, HIGH);
+            hostAdvance(300);
+        }
+        hostSetPin(SW, LOW);
+        hostRunFor(200);
+        hostSetPin(SW, HIGH);
+        hostAdvance(300);
+        hostSetPin(SW, LOW);
+        hostAdvance(300);
+        hostSetPin(SW, HIGH);
+        hostRunFor(300);
+    }
+
+    passed &= check(mode == 3, "3 presses: mode %d", mode);
+
+    return passed;
+}
+
+/**
+ * @brief Prints the Bluetooth and LED statistics on the USB serial console.
+ */
+static bool scenarioConsole() {
+    bool passed = true;
+
+    holdRemote(REMOTE_CENTER, 200, 500);
+    std::string response = requestConsole("l");
+
+    std::string link = findLine(response, "BT link:");
+    std::string led = findLine(response, "LED frames:");
+
+    passed &= check(link.find("valid 50,") != std::string::npos, "link statistics: %s", link.c_str());
+    passed &= check(!led.empty(), "LED statistics: %s", led.c_str());
+
+    return passed;
+}
+
+/**
+ * @brief Drives with the hardware joystick, which gives way to the remote while the link is active.
+ */
+static bool scenarioHardwareJoystick() {
+#ifdef JOYSTICK_HARDWARE
+    bool passed = true;
+
+    hostSetAnalog(JOYSTICK_ADC_CHANNEL_X, DEFAULT_POSITION);
+    hostSetAnalog(JOYSTICK_ADC_CHANNEL_Y, MAX_POSITION);
+    hostRunFor(1000);
+    passed &= check(speedLeft() > 0 && speedRight() > 0, "hardware joystick forward: both motors run (PWM %u, %u)", speedLeft(), speedRight());
+
+    holdRemote(REMOTE_CENTER, REMOTE_CENTER, 1000);
+    passed &= check(speedLeft() == 0 && speedRight() == 0, "remote at rest takes over: motors off (PWM %u, %u)", speedLeft(), speedRight());
+
+    hostRunFor(BT_COMMAND_TIMEOUT + 1000);
+    passed &= check(speedLeft() > 0 && speedRight() > 0, "remote silent: hardware joystick again (PWM %u, %u)", speedLeft(), speedRight());
+
+    return passed;
+#else
+    return check(false, "requires JOYSTICK_HARDWARE");
+#endif
+}
+
+#ifdef PROFILE_TIMING
+
+/**
+ * @brief Gets a percentile of sorted measures.
+ * @param sorted Measures in increasing order, at least one.
+ * @param percent Percentile, in [1; 100].
+ */
+static unsigned long percentile(const std::vector<unsigned long>& sorted, unsigned percent) {
+    // Rank of the percentile, rounded up
+    size_t rank = (sorted.size() * percent + 99) / 100;
+    return sorted[rank - 1];
+}
+
+/**
+ * @brief Moves the stick of the remote sketch back and forth under the current load, and measures the latency from the
+ *        first ADC sample of the remote after each move to the next change of the motor PWM.
+ * @param load Name of the load, for the report.
+ */
+static bool measureLatency(const char* load) {
+    bool passed = true;
+    std::vector<unsigned long> latencies;
+
+    // Resets the statistics of the firmware
+    hostSerialEcho(false);
+    requestConsole("p");
+    hostSerialEcho(true);
+
+    for (uint8_t step = 0; step < LATENCY_STEPS; step++) {
+        remoteSetJoystick(STICK_CENTER, (step & 1) ? STICK_CENTER : STICK_FORWARD);
+
+        uint64_t moved = hostTime();
+        uint64_t sample = 0;
+        unsigned long elapsed = 0;
+
+        while (elapsed < LATENCY_HOLD) {
+            remoteRunFor(1);
+            elapsed++;
+
+            if (sample == 0 && remoteSampleTime() >= moved) {
+                sample = remoteSampleTime();
+            }
+
+            if (sample != 0 && hostMotorPwmChangeTime() > sample) {
+                latencies.push_back((hostMotorPwmChangeTime() - sample) / 1000);
+                break;
+            }
+        }
+
+        remoteRunFor(LATENCY_HOLD - elapsed);
+    }
+
+    passed &= check(latencies.size() == LATENCY_STEPS, "%s: %u of %u moves changed the PWM", load, (unsigned)latencies.size(), LATENCY_STEPS);
+    if (latencies.empty()) {
+        return false;
+    }
+
+    std::sort(latencies.begin(), latencies.end());
+    unsigned long p99 = percentile(latencies, 99);
+
+    passed &= check(p99 <= LATENCY_LIMIT, "%s: ADC sample to PWM p50 %lu us, p99 %lu us, max %lu us (limit %u us)",
+                    load, percentile(latencies, 50), p99, latencies.back(), LATENCY_LIMIT);
+
+    // Robot part, measured by the firmware from the reception of the command
+    std::string latency = findLine(requestConsole("p"), "input to PWM");
+    passed &= check(latency.find(" PASS") != std::string::npos, "%s: firmware %s", load, latency.c_str());
+
+    return passed;
+}
+
+#endif
+
+/**
+ * @brief Measures the input to actuation latency with the remote sketch under the load given as argument.
+ * @details music: mode 0 right after boot, static LEDs and a song. idle: the same mode once the song is over.
+ *          led: the last mode, a new LED frame at 60 fps without music.
+ */
+static bool scenarioLatency() {
+#ifdef PROFILE_TIMING
+    bool passed = true;
+    const char* load = scenarioArgument ? scenarioArgument : "";
+
+    remoteBegin();
+    remoteRunFor(500);
+
+    if (strcmp(load, "idle") == 0) {
+        // Waits for the end of the song, the buzzer silent for one second
+        for (uint16_t seconds = 0; seconds < 600; seconds++) {
+            unsigned long toggles = hostPinToggles(BUZZER_PIN);
+            remoteRunFor(1000);
+
+            if (hostPinToggles(BUZZER_PIN) == toggles) {
+                break;
+            }
+        }
+    } else if (strcmp(load, "led") == 0) {
+        // Presses the select button of the remote up to the last mode
+        for (uint8_t i = 0; i < ledPatternCount && mode != ledPatternCount - 1; i++) {
+            remoteSetSelect(true);
+            remoteRunFor(100);
+            remoteSetSelect(false);
+            remoteRunFor(100);
+        }
+    } else if (strcmp(load, "music") != 0) {
+        return check(false, "unknown load \"%s\", expected idle, led or music", load);
+    }
+
+    unsigned long toggles = hostPinToggles(BUZZER_PIN);
+    unsigned long frames = hostStripStats().latchedFrames;
+
+    passed &= measureLatency(load);
+    check(true, "%s: mode %d, buzzer toggles %lu, LED frames %lu", load, mode,
+          hostPinToggles(BUZZER_PIN) - toggles, hostStripStats().latchedFrames - frames);
+
+    if (strcmp(load, "music") == 0) {
+        passed &= check(hostPinToggles(BUZZER_PIN) > toggles, "music played");
+    } else {
+        passed &= check(hostPinToggles(BUZZER_PIN) == toggles, "no music");
+    }
+
+    if (strcmp(load, "led") == 0) {
+        passed &= check(mode == ledPatternCount - 1, "last mode selected");
+    }
+
+    return passed;
+#else
+    return check(false, "requires PROFILE_TIMING");
+#endif
+}
+
+/**
+ * @brief Holds the select button of the remote sketch for one second while driving: the robot changes mode once and
+ *        keeps moving, since the remote keeps sending its last position.
+ */
+static bool scenarioRemoteSelect() {
+    bool passed = true;
+
+    remoteBegin();
+    remoteSetJoystick(STICK_CENTER, STICK_FORWARD);
+    remoteRunFor(1000);
+
+    int previous = mode;
+    uint16_t timeouts = btLinkStats.timeouts;
+
+    remoteSetSelect(true);
+    remoteRunFor(1000);
+    passed &= check(speedLeft() > 0 && speedRight() > 0, "select held: motors still run (PWM %u, %u)", speedLeft(), speedRight());
+
+    remoteSetSelect(false);
+    remoteRunFor(200);
+
+    passed &= check(btLinkStats.timeouts == timeouts, "no link timeout (%u)", btLinkStats.timeouts - timeouts);
+    passed &= check(mode == (previous + 1) % ledPatternCount, "mode %d then %d", previous, mode);
+    passed &= check(remoteSerialOutput().find('M') != std::string::npos, "remote printed the mode change");
+
+    return passed;
+}
+
+/**
+ * @brief Streams joystick frames from the remote in the mode sending a new LED frame at 60 fps, and reports the received
+ *        bytes lost by the UART and the frames lost.
+ * @details Run with both LED strip drivers, see STRIP_CHUNKED_OUTPUT and compare_strip.cmake: the standard driver must
+ *          lose bytes under this load, the chunked driver none.
+ */
+static bool scenarioStrip() {
+    bool passed = true;
+
+    selectMode(ledPatternCount - 1);
+    hostRunFor(100);
+
+    uint16_t overruns = BlueT.overruns();
+    uint16_t valid = btLinkStats.validFrames;
+    uint16_t malformed = btLinkStats.malformedFrames;
+    uint16_t dropped = btLinkStats.droppedFrames;
+    hostStripStats_t before = hostStripStats();
+    hostMaxInterruptsOff();
+
+    // Joystick moving back and forth, a frame every REMOTE_PERIOD
+    unsigned sent = 0;
+
+    for (unsigned long elapsed = 0; elapsed < STRIP_LOAD_TIME; elapsed += REMOTE_PERIOD) {
+        uint8_t step = (elapsed / REMOTE_PERIOD) % 128;
+        holdRemote(REMOTE_CENTER, step < 64 ? 128 + 2 * step : 383 - 2 * step, REMOTE_PERIOD);
+        sent++;
+    }
+
+    hostStripStats_t after = hostStripStats();
+    unsigned long latched = after.latchedFrames - before.latchedFrames;
+    unsigned long partial = after.partialFrames - before.partialFrames;
+
+    overruns = BlueT.overruns() - overruns;
+    valid = btLinkStats.validFrames - valid;
+    malformed = btLinkStats.malformedFrames - malformed;
+    dropped = btLinkStats.droppedFrames - dropped;
+
+    unsigned lost = (valid < sent) ? sent - valid : 0;
+
+#ifdef STRIP_CHUNKED_OUTPUT
+    const char* driver = "chunked";
+#else
+    const char* driver = "standard";
+#endif
+
+    check(true, "strip %-8s: UART overruns %3u (%5.1f /s), frames lost %3u of %u (%4.1f %%), malformed %3u, dropped %3u, interrupts off up to %4lu us",
+          driver, overruns, overruns * 1000.0 / STRIP_LOAD_TIME, lost, sent, lost * 100.0 / sent, malformed, dropped, hostMaxInterruptsOff());
+
+    // 60 fps, less the frames sent late by the scheduler
+    passed &= check(latched >= STRIP_LOAD_TIME * 54 / 1000 && partial == 0, "LED frames latched %lu, partial %lu", latched, partial);
+
+#ifdef STRIP_CHUNKED_OUTPUT
+    passed &= check(overruns == 0 && lost == 0 && malformed == 0 && dropped == 0, "no received byte lost");
+#else
+    passed &= check(overruns > 0 && lost > 0, "received bytes lost while the strip is sent");
+#endif
+
+    return passed;
+}
+
+/**
+ * @brief Checks the verdict printed at startup by a benchmark of the firmware.
+ * @details The argument is the start of the verdict line, e.g. "BT decoder benchmark" in a BENCHMARK_BT build.
+ */
+static bool scenarioBenchmark() {
+    const char* name = scenarioArgument ? scenarioArgument : "";
+    std::string verdict = findLine(hostSerialOutput(), name);
+    std::string expected = std::string(name) + " PASS";
+
+    if (*name == '\0' || verdict.empty()) {
+        return check(false, "verdict \"%s\" printed", name);
+    }
+
+    verdict.erase(verdict.find_last_not_of("\r") + 1);
+    return check(verdict == expected, "%s", verdict.c_str());
+}
+
+/**
+ * @brief Computes the mixer outputs over the whole grid of joystick bytes, as decoded from the remote.
+ * @details The targets are filled with an invalid value before each call, so that an output left unset by the mixer
+ *          shows up in the table.
+ * @return One line per position: "<X byte> <Y byte> <left mode> <left speed> <right mode> <right speed>".
+ */
+static std::string computeMixerTable() {
+    std::string table = "# X Y modeL speedL modeR speedR\n";
+    char line[32];
+
+    for (int x = 0; x < 256; x++) {
+        for (int y = 0; y < 256; y++) {
+            targetDriveModeL = targetDriveModeR = (driveMode_t)0xFF;
+            targetSpeedL = targetSpeedR = 0xFF;
+
+            computeDriveModesAndSpeeds(4 * x - DEFAULT_POSITION, 4 * y - DEFAULT_POSITION);
+
+            snprintf(line, sizeof(line), "%d %d %d %u %d %u\n", x, y, targetDriveModeL, targetSpeedL, targetDriveModeR, targetSpeedR);
+            table += line;
+        }
+    }
+
+    return table;
+}
+
+/**
+ * @brief Compares the mixer outputs over the whole grid of joystick bytes with the expected table given as argument.
+ */
+static bool scenarioMixer() {
+    bool passed = true;
+    std::string expected;
+    FILE* file = scenarioArgument ? fopen(scenarioArgument, "r") : NULL;
+
+    if (file == NULL) {
+        return check(false, "expected table %s not found", scenarioArgument ? scenarioArgument : "(none)");
+    }
+
+    char buffer[4096];
+    size_t length;
+    while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        expected.append(buffer, length);
+    }
+    fclose(file);
+
+    std::string table = computeMixerTable();
+    size_t tableLine = 0;
+    size_t expectedLine = 0;
+    unsigned long differences = 0;
+
+    // Line by line, reporting the first differences
+    while (tableLine < table.size() || expectedLine < expected.size()) {
+        size_t tableEnd = table.find('\n', tableLine);
+        size_t expectedEnd = expected.find('\n', expectedLine);
+        std::string actualText = tableLine < table.size() ? table.substr(tableLine, tableEnd - tableLine) : "(end)";
+        std::string expectedText = expectedLine < expected.size() ? expected.substr(expectedLine, expectedEnd - expectedLine) : "(end)";
+
+        if (actualText != expectedText && differences++ < 10) {
+            check(false, "expected \"%s\", got \"%s\"", expectedText.c_str(), actualText.c_str());
+        }
+
+        tableLine = (tableEnd == std::string::npos) ? table.size() : tableEnd + 1;
+        expectedLine = (expectedEnd == std::string::npos) ? expected.size() : expectedEnd + 1;
+    }
+
+    passed &= check(differences == 0, "256 x 256 positions match %s (%lu differences)", scenarioArgument, differences);
+
+    // Full backward with a left turn: the former mixer left the right wheel speed unset
+    targetSpeedR = 0xFF;
+    computeDriveModesAndSpeeds(-DEFAULT_POSITION, -DEFAULT_POSITION / 2);
+    passed &= check(targetDriveModeR == BACKWARDS && targetSpeedR == FULL_SPEED && targetDriveModeL == BACKWARDS && targetSpeedL == FULL_SPEED / 2,
+                    "backward left turn: right wheel %d %u, left wheel %d %u", targetDriveModeR, targetSpeedR, targetDriveModeL, targetSpeedL);
+
+    return passed;
+}
+
+/**
+ * @brief Writes the mixer outputs over the whole grid of joystick bytes to the file given as argument, to update the
+ *        expected table of scenarioMixer() after an intended change of the mixer.
+ */
+static bool scenarioMixerUpdate() {
+    FILE* file = scenarioArgument ? fopen(scenarioArgument, "w") : NULL;
+
+    if (file == NULL) {
+        return check(false, "cannot write %s", scenarioArgument ? scenarioArgument : "(none)");
+    }
+
+    std::string table = computeMixerTable();
+    bool written = fwrite(table.data(), 1, table.size(), file) == table.size();
+
+    return check(fclose(file) == 0 && written, "mixer table written to %s", scenarioArgument);
+}
+
+static const scenario_t scenarios[] = {
+    { "boot", scenarioBoot },
+    { "drive", scenarioDrive },
+    { "lost_sync", scenarioLostSync },
+    { "phone", scenarioPhone },
+    { "music", scenarioMusic },
+    { "switch", scenarioSwitch },
+    { "console", scenarioConsole },
+    { "hardware_joystick", scenarioHardwareJoystick },
+    { "latency", scenarioLatency },
+    { "remote_select", scenarioRemoteSelect },
+    { "strip", scenarioStrip },
+    { "benchmark", scenarioBenchmark },
+    { "mixer", scenarioMixer },
+    { "mixer_update", scenarioMixerUpdate }
+};
+
+int main(int argc, char** argv) {
+    const scenario_t* scenario = NULL;
+    int first = 1;
+
+    if (argc > 2 && strcmp(argv[1], "--cpu-scale") == 0) {
+        hostSetCpuScale(atof(argv[2]));
+        first = 3;
+    }
+
+    for (uint8_t i = 0; first < argc && argc <= first + 2 && i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+        if (strcmp(argv[first], scenarios[i].name) == 0) {
+            scenario = &scenarios[i];
+            scenarioArgument = (argc == first + 2) ? argv[first + 1] : NULL;
+        }
+    }
+
+    if (scenario == NULL) {
+        fprintf(stderr, "Usage: %s [--cpu-scale <factor>] <scenario> [<argument>]\nScenarios:", argv[0]);
+        for (uint8_t i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+            fprintf(stderr, " %s", scenarios[i].name);
+        }
+        fputc('\n', stderr);
+        return 2;
+    }
+
+    init();
+    hostRunFirmware(setup);
+
+    bool passed = scenario->run();
+
+    fflush(stdout);
+    fprintf(stderr, "sim: %s %s at %lu ms\n", scenario->name, passed ? "PASS" : "FAIL", millis());
+
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,37 @@
+/**
+ * @file benchmark.h
+ * @brief Header file containing the cycle count benchmark declarations and configurations.
+ * @details Measures the exact number of CPU cycles spent in the hot functions of the firmware with the Timer5 cycle counter,
+ *          interrupts disabled, and prints one "cycles <function> <case> <count>" line per measure on the serial port.
+ *          Tools/compare_cycles.py compares these lines with a baseline recorded on the robot in Tools/cycles_baseline.txt.
+ *          Everything compiles out when BENCHMARK_CYCLES is not defined.
+ */
+
+#pragma once
+
+//=============================================================================
+//                       INCLUDE LIBRARIES AND HEADER FILES
+//=============================================================================
+
+#include "utils.h"
+
+//=============================================================================
+//                                   MACROS
+//=============================================================================
+
+/**
+ * @brief Step of the joystick positions grid of the drive mixer measure, on both axes.
+ */
+#define BENCHMARK_MIXER_STEP 64
+
+//=============================================================================
+//                           ROUTINE PROTOTYPES
+//=============================================================================
+
+/**
+ * @brief Prints the cycles spent computing an LED frame (renderLED_Frame()) for each mode, in computeDriveModesAndSpeeds() over a grid of positions,
+ *        in parseValue(), intToUint8_t() and in the first buzz() call of each song.
+ * @details Must be called at the end of setup(), once the strip is initialized. The mode, the motor targets and the tone engine are restored afterwards.
+ *          Only defined when BENCHMARK_CYCLES is enabled.
+ */
+extern void benchmarkCycles();
@@ -10,40 +10,182 @@
 //                       INCLUDE LIBRARIES AND HEADER FILES
 //=============================================================================
 
-// Needed to create a Bluetooth communication instance.
-#include <SoftwareSerial.h>
+// Needed to create a Bluetooth communication instance (Stream interface).
+#include <Arduino.h>
 
 #include "joystick.h"
 
 #include "../Inc/utils.h"
 
+//=============================================================================
+//                              TYPE DECLARATIONS
+//=============================================================================
+
+/**
+ * @brief Enumeration for the message types of the binary protocol.
+ */
+typedef enum btMessage_t {
+    BT_MSG_JOYSTICK = 0x01, /**< Joystick position, X and Y bytes in [0; 255] */
+    BT_MSG_MODE = 0x02      /**< Change the LED and buzzer mode, X and Y bytes are unused */
+} btMessage_t;
+
+/**
+ * @brief Quality statistics of the Bluetooth control link.
+ * @details The frames are timestamped when they are decoded by the input task, so the intervals include its scheduling delay (up to one task period).
+ */
+typedef struct btLinkStats_t {
+    unsigned long lastFrameTime;    /**< Time the last valid command was decoded (ms) */
+    unsigned long lastFrameMicros;  /**< Time the last valid command was decoded (µs), for the intervals */
+    unsigned long lastInterval;     /**< Interval between the last two valid commands (µs) */
+    unsigned long maxInterval;      /**< Longest interval between two valid commands (µs) */
+    unsigned long jitter;           /**< Smoothed variation between consecutive intervals (µs), as in RFC 3550 */
+    uint16_t validFrames;           /**< Number of valid commands */
+    uint16_t malformedFrames;       /**< Number of frames with a wrong CRC, a missing or out of range value, or truncated */
+    uint16_t droppedFrames;         /**< Number of binary frames missing from the sequence numbers */
+    uint16_t timeouts;              /**< Number of times the failsafe stopped the robot */
+    uint8_t lastSequence;           /**< Sequence number of the last binary frame */
+    bool sequenceValid;             /**< Whether lastSequence was received since the link was established */
+    bool linkActive;                /**< Whether a valid command was received within BT_COMMAND_TIMEOUT */
+    bool binaryLink;                /**< Whether a valid binary frame was received since the link was established: the legacy commands are then ignored */
+} btLinkStats_t;
+
 //=============================================================================
 //                                   MACROS
 //=============================================================================
 
 /**
- * @brief Defines the RX digital pin for the Bluetooth module.
+ * @brief Hardware UART the Bluetooth module is wired to (1 or 2).
+ * @details UART 1 uses pins 19 (RX1) and 18 (TX1), UART 2 uses pins 17 (RX2) and 16 (TX2).
+ * @note The selected UART is driven by BluetoothUart, the matching SerialN instance must not be used.
  */
-#define RX 11
+#define BT_UART 1
 
 /**
- * @brief Defines the TX digital pin for the Bluetooth module.
+ * @brief Size of the interrupt-driven receive ring buffer of the Bluetooth UART. Must be a power of two, 256 at most.
  */
-#define TX 12
+#define BT_RX_BUFFER_SIZE 128
 
 /**
  * @brief Rate the Bluetooth module communicates at.
  */
 #define BT_RATE 57600
 
+/**
+ * @brief Size of the buffer holding a joystick frame, without its '*' prefix and '_' suffix ("X<value_X>,Y<value_Y>").
+ */
+#define BT_FRAME_SIZE 16
+
+/**
+ * @brief First byte of a binary frame. It is outside the ASCII range so it can't be mistaken for a legacy command.
+ * @details A binary frame is made of: BT_SYNC, message type, X, Y, sequence number and CRC-8 of the 4 previous bytes.
+ */
+#define BT_SYNC 0xA5
+
+/**
+ * @brief Size of a binary frame, sync byte and CRC included.
+ */
+#define BT_BINARY_FRAME_SIZE 6
+
+/**
+ * @brief CRC-8 polynomial used by the binary protocol (x^8 + x^2 + x + 1).
+ */
+#define BT_CRC8_POLYNOMIAL 0x07
+
+/**
+ * @brief Time without any valid command after which the robot is stopped (ms).
+ * @note Must be longer than the keep-alive period of the remote.
+ */
+#define BT_COMMAND_TIMEOUT 500
+
+/**
+ * @brief Character to send on the serial port to print the Bluetooth link statistics.
+ */
+#define BT_STATS_REQUEST 'l'
+
+/**
+ * @brief Lowest acceptable decoding throughput of the Bluetooth decoder benchmark (bytes/s).
+ * @details Ten times the 5760 bytes/s carried by the link at BT_RATE baud, so that decoding takes at most 10 % of the CPU at full link load.
+ */
+#define BENCHMARK_BT_MIN_RATE 57600
+
+//=============================================================================
+//                              CLASS DECLARATIONS
+//=============================================================================
+
+/**
+ * @brief Bluetooth transport over a hardware UART.
+ * @details Received bytes are stored by the UART receive interrupt in a ring buffer of BT_RX_BUFFER_SIZE bytes,
+ * so no byte is lost while the main loop or another interrupt-sensitive routine is busy, as long as the buffer does not fill up.
+ * Bytes are sent by polling the UART, which is enough for the few bytes sent to the module.
+ */
+class BluetoothUart : public Stream {
+    public:
+        /**
+         * @brief Configures the UART and enables its receive interrupt.
+         * @param baud Rate the Bluetooth module communicates at.
+         */
+        void begin(unsigned long baud);
+
+        /**
+         * @brief Gets the number of received bytes waiting in the ring buffer.
+         * @return Number of bytes that can be read.
+         */
+        int available();
+
+        /**
+         * @brief Reads the next received byte.
+         * @return The byte, or -1 if the ring buffer is empty.
+         */
+        int read();
+
+        /**
+         * @brief Gets the next received byte without removing it from the ring buffer.
+         * @return The byte, or -1 if the ring buffer is empty.
+         */
+        int peek();
+
+        /**
+         * @brief Sends a byte, waiting for the UART to be ready.
+         * @param byte The byte to send.
+         * @return Number of bytes sent.
+         */
+        size_t write(uint8_t byte);
+
+        using Print::write;
+
+        /**
+         * @brief Gets the number of received bytes dropped because the ring buffer was full.
+         * @return Number of dropped bytes since begin().
+         */
+        uint16_t overflows();
+
+        /**
+         * @brief Gets the number of received bytes lost by the UART because the receive interrupt was held off, e.g. while the LED strip is sent.
+         * @return Number of data overruns since begin(). Several bytes may have been lost at each overrun.
+         */
+        uint16_t overruns();
+
+        /**
+         * @brief Gets the reception time of the last byte read.
+         * @return Time the receive interrupt stored the byte (µs).
+         * @note Only defined when PROFILE_TIMING is enabled.
+         */
+        unsigned long readTime();
+};
+
 //=============================================================================
 //                              VARIABLE DECLARATIONS
 //=============================================================================
 
 /**
-* @brief SoftwareSerial instance for the Bluetooth module.
+* @brief Hardware UART instance for the Bluetooth module.
+*/
+extern BluetoothUart BlueT;
+
+/**
+* @brief Quality statistics of the Bluetooth control link, updated by BT_process() and BT_checkTimeout().
 */
-extern SoftwareSerial BlueT;
+extern btLinkStats_t btLinkStats;
 
 //=============================================================================
 //                           ROUTINE PROTOTYPES
@@ -56,18 +198,51 @@ extern SoftwareSerial BlueT;
  * It supports various commands that can:
  *      - move the coordinates to predefined positions : case where data is sent using a pad with few possible values.
  *      - allow parsing of custom coordinate values : case where data is sent from a joystick via Bluetooth (from a smartphone or not).
+ *      - decode the binary frames sent by the TI remote, starting with BT_SYNC.
+ *
+ * Once a valid binary frame is received, the legacy ASCII and pad commands are ignored until the link times out:
+ * they can only be the payload of a binary frame whose sync byte was lost, which the CRC would not protect.
+ *
+ * The function never blocks and does not allocate memory: it only consumes the bytes already received, a joystick frame can be split over several calls.
  *
  * @param scaled_X Pointer to an integer that will hold the updated scaled X coordinate.
  * @param scaled_Y Pointer to an integer that will hold the updated scaled Y coordinate.
- * @return True if the motors should be updated, false otherwise (case where just the mode is updated).
+ * @return True if the motors should be updated, false otherwise (case where just the mode is updated or no complete command was received).
  */
 extern bool BT_process(int* scaled_X, int* scaled_Y);
 
+/**
+ * @brief Checks whether the link has been silent for BT_COMMAND_TIMEOUT since the last valid command.
+ * @return True once when the timeout expires, then false until a new valid command is received.
+ */
+extern bool BT_checkTimeout();
+
+/**
+ * @brief Prints the Bluetooth link statistics on the serial port.
+ */
+extern void BT_printStats();
+
+/**
+ * @brief Feeds generated, mutated and random streams to BT_process() and prints its throughput and robustness checks.
+ * @details Checks that every call makes progress, that the decoded values stay within [- DEFAULT_POSITION; DEFAULT_POSITION],
+ *          that the legal frames are all decoded and that no memory is allocated. Must be called before BlueT.begin().
+ *          Only defined when BENCHMARK_BT is enabled.
+ */
+extern void benchmarkBT_process();
+
 /**
  * Parses a value from a string of data.
  *
- * @param data The string of data to parse. Its format is expected to be "X<value_X>,Y<value_Y>
+ * @param data The null-terminated string of data to parse. Its format is expected to be "X<value_X>,Y<value_Y>"
  * @param axis The character representing the axis to parse ('X' or 'Y').
- * @return The parsed value, or 0 if the axis is not found.
+ * @return The parsed value in [0; 255], or -1 if the axis is not found or its value is missing or out of range.
+ */
+extern int parseValue(const char* data, char axis);
+
+/**
+ * @brief Computes the CRC-8 of a binary frame.
+ * @param data Bytes to compute the CRC of.
+ * @param length Number of bytes.
+ * @return The CRC-8 (polynomial BT_CRC8_POLYNOMIAL, initial value 0).
  */
-extern int parseValue(String data, char axis);
\ No newline at end of file
+extern uint8_t crc8(const uint8_t* data, uint8_t length);
\ No newline at end of file
@@ -17,10 +17,44 @@
  #include <pitches.h>
 
  #include "strip_led.h"
+
+ #include "tone_engine.h"
  
  #include "utils.h"
  
  
+ //=============================================================================
+ //                              TYPE DECLARATIONS
+ //=============================================================================
+
+ /**
+  * @brief Index of each music track in song_tab, used by the LED pattern registry to select the music of each mode.
+  */
+ typedef enum songId_t {
+     SONG_PINK_PANTHER,     /**< Pink Panther theme */
+     SONG_NOKIA,            /**< Nokia ringtone */
+     SONG_SUBWAY_SURFERS,   /**< Subway Surfers theme */
+     SONG_THE_SIMPSONS,     /**< The Simpsons theme */
+     SONG_COUNT             /**< Number of music tracks */
+ } songId_t;
+
+ /**
+  * @brief One note of a song, stored in flash.
+  */
+ typedef struct songNote_t {
+     uint8_t pitch;     /**< Index of the note in pitch_tab (pitchIndex_t) */
+     uint8_t duration;  /**< Duration code: the note lasts the whole note duration divided by 2^duration */
+ } songNote_t;
+
+ /**
+  * @brief Header of a song, stored in flash.
+  */
+ typedef struct song_t {
+     const songNote_t* notes;  /**< Notes of the song, in flash */
+     uint16_t length;          /**< Number of notes */
+     uint16_t wholeNote;       /**< Duration of a whole note (ms), sets the tempo */
+ } song_t;
+
  //=============================================================================
  //                                   MACROS
  //=============================================================================
@@ -31,13 +65,29 @@
   */
  #define BUZZER_PIN  2
  
+ /**
+  * @brief Duration codes of the notes.
+  * @details The duration of a note is the whole note duration shifted right by its code.
+  */
+ #define WHOLE          0
+ #define HALF           1
+ #define QUARTER        2
+ #define EIGHTH         3
+ #define SIXTEENTH      4
+ #define THIRTY_SECOND  5
+
+ /**
+  * @brief Builds the header of a song from its notes array and its whole note duration (ms).
+  */
+ #define SONG(notes, wholeNote) { (notes), sizeof(notes) / sizeof(songNote_t), (wholeNote) }
+
  //=============================================================================
  //                             VARIABLE DECLARATIONS
  //=============================================================================
  
  /**
   * @brief Current note being played by the buzzer.
-  * @details Stores the frequency value of the currently playing musical note.
+  * @details Stores the index of the next note of the current track to queue to the tone engine.
   */
  extern int note;
  
@@ -46,83 +96,50 @@
  //------------------------------------------------------------------------------
  
  /**
-  * @brief Melody array for Pink Panther theme.
-  * @details Contains frequency values for each note in the Pink Panther theme song.
-  */
- extern const int melody_PinkPanther[];
- 
- /**
-  * @brief Duration array for Pink Panther theme.
-  * @details Contains duration values corresponding to each note in melody_PinkPanther.
+  * @brief Notes of the Pink Panther theme, stored in flash.
   */
- extern const int durations_PinkPanther[]; 
+ extern const songNote_t song_PinkPanther[] PROGMEM;
  
  //------------------------------------------------------------------------------
  // NOKIA
  //------------------------------------------------------------------------------
  
  /**
-  * @brief Melody array for Nokia ringtone.
-  * @details Contains frequency values for each note in the Nokia ringtone.
+  * @brief Notes of the Nokia ringtone, stored in flash.
   */
- extern const int melody_Nokia[];
- 
- /**
-  * @brief Duration array for Nokia ringtone.
-  * @details Contains duration values corresponding to each note in melody_Nokia.
-  */
- extern const int durations_Nokia[];
+ extern const songNote_t song_Nokia[] PROGMEM;
  
  //------------------------------------------------------------------------------
  // SUBWAY SURFERS
  //------------------------------------------------------------------------------
  
  /**
-  * @brief Melody array for Subway Surfers theme.
-  * @details Contains frequency values for each note in the Subway Surfers theme.
+  * @brief Notes of the Subway Surfers theme, stored in flash.
   */
- extern const int melody_SubwaySurfers[];
- 
- /**
-  * @brief Duration array for Subway Surfers theme.
-  * @details Contains duration values corresponding to each note in melody_SubwaySurfers.
-  */
- extern const int durations_SubwaySurfers[];
+ extern const songNote_t song_SubwaySurfers[] PROGMEM;
  
  //------------------------------------------------------------------------------
  // THE SIMPSONS 
  //------------------------------------------------------------------------------
  
  /**
-  * @brief Melody array for The Simpsons theme.
-  * @details Contains frequency values for each note in The Simpsons theme song.
-  */
- extern const int melody_TheSimpsons[];
- 
- /**
-  * @brief Duration array for The Simpsons theme.
-  * @details Contains duration values corresponding to each note in melody_TheSimpsons.
+  * @brief Notes of The Simpsons theme, stored in flash.
   */
- extern const int durations_TheSimpsons[];
+ extern const songNote_t song_TheSimpsons[] PROGMEM;
  
  //------------------------------------------------------------------------------
  // MUSIC TABS
  //------------------------------------------------------------------------------
  
  /**
-  * @brief Array containing the sizes of all the music tracks.
-  */
- extern const int* const size_tab[];
- 
- /**
-  * @brief Array containing the addresses of the duration array for each music track.
+  * @brief Header of every music track, stored in flash.
   */
- extern const int* const durations_tab[];
+ extern const song_t song_tab[] PROGMEM;
  
  /**
-  * @brief Array containing the addresses of the melody array for each music track.
+  * @brief Number of music tracks in song_tab.
   */
- extern const int* const  melody_tab[];
+ extern const uint8_t song_tab_size;
  
  //=============================================================================
  //                           ROUTINE PROTOTYPES
@@ -131,6 +148,7 @@
  /**
   * @brief Main buzzer control function.
   * @details Handles the buzzer output and note playing functionality based on current mode.
+  *          Never blocks: the upcoming notes are queued to the tone engine, which plays them from the Timer1 interrupt.
   */
  extern void buzz();
  
\ No newline at end of file
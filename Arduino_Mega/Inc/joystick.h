@@ -11,7 +11,7 @@
 
 #include "motor.h"
 
-#include "strip_LED.h"
+#include "strip_led.h"
 
 #include "buzzer.h"
 
@@ -55,11 +55,45 @@ typedef enum joystickInput_t {
 */
 #define MAX_POSITION 1023
 
+/**
+* @brief Throttle (scaled X) from which the mixer only performs arc turns. Below it, the turn is blended with a pivot turn.
+* @note Must be a power of two so that the blending weight is computed without division.
+*/
+#define PIVOT_LIMIT 128
+
 /**
 * @brief Joystick analog switch pin.
 */
 #define SW 3
 
+/**
+* @brief Input register and bit of the joystick switch pin, used by the external interrupt.
+* @details Pin 3 is PE5 on the ATmega2560, external interrupt INT5 (interrupt 1 in the Arduino numbering).
+* @note Must match SW.
+*/
+#define SW_PIN_REG PINE
+#define SW_BIT PE5
+
+/**
+* @brief Enables the hardware joystick, which drives the robot while the Bluetooth link is inactive.
+* This macro can be uncommented when a joystick is wired to A0 and A1. The ADC acquisition only runs when it is enabled,
+* since its interrupt fires about 9600 times per second and keeps waking the CPU from idle.
+*/
+// #define JOYSTICK_HARDWARE
+
+/**
+* @brief ADC channels of the hardware joystick axes (A0 and A1).
+*/
+#define JOYSTICK_ADC_CHANNEL_X 0
+#define JOYSTICK_ADC_CHANNEL_Y 1
+
+/**
+* @brief Number of ADC samples averaged into one filtered sample of an axis. Must be a power of two, at most 64.
+* @details The ADC runs at 125 kHz (prescaler 128), i.e. about 9600 conversions per second shared by both axes:
+*          with 16 samples, each axis gets a new filtered sample about every 3.3 ms.
+*/
+#define JOYSTICK_OVERSAMPLING 16
+
 //=============================================================================
 //                             VARIABLE DECLARATIONS
 //=============================================================================
@@ -75,6 +109,11 @@ extern const unsigned int debounceDelay;
  */
 extern joystickInput_t JOYSTICK_INPUT;
 
+/**
+ * @brief Latest filtered samples of the hardware joystick axes (X, Y), in [0; MAX_POSITION], updated by the ADC interrupt.
+ */
+extern volatile uint16_t joystickAdcValues[2];
+
 //=============================================================================
 //                           ROUTINE PROTOTYPES
 //=============================================================================
@@ -82,39 +121,63 @@ extern joystickInput_t JOYSTICK_INPUT;
 /**
  * @brief Reads and processes joystick input to control motor speeds and directions.
  * @details Reads joystick input from either Bluetooth or hardware sources, scales the input, and computes the appropriate motor drive modes and speeds. 
- * If the joystick input indicates that the motors should be updated, it calls the `computeDriveModesAndSpeeds()` and `applyMotorsSettings()` functions to update the motor states.
- * @see computeDriveModesAndSpeeds(
+ * If the joystick input indicates that the motors should be updated, it calls the `computeDriveModesAndSpeeds()` function to update the motor targets.
+ * If no valid Bluetooth command was received for BT_COMMAND_TIMEOUT, the motor targets are set to STOPPED.
+ * The motor task ramps the motor states toward the targets and applies them to the motors, see `updateMotorsRamp()` and `applyMotorsSettings()`.
+ * @see computeDriveModesAndSpeeds()
+ * @see updateMotorsRamp()
  * @see applyMotorsSettings()
  */
 extern void readJoystick();
 
+/**
+ * @brief Starts the background acquisition of the hardware joystick axes.
+ * @details The ADC conversions are chained by the ADC interrupt, which alternates between both axes and averages
+ *          JOYSTICK_OVERSAMPLING samples per axis. analogRead() must not be used while the acquisition is running.
+ *          Only called when JOYSTICK_HARDWARE is enabled.
+ */
+extern void joystickAdcBegin();
+
 /**
  * @brief Reads and scales the hardware joystick input.
- * @details Reads the X and Y values from the hardware joystick, scales them to the appropriate range, and stores the scaled values in the provided pointers.
+ * @details Reads the latest filtered X and Y values acquired in background by the ADC interrupt, scales them to the appropriate range, and stores the scaled values in the provided pointers.
  * @param scaled_X Pointer to an integer where the scaled X value will be stored.
  * @param scaled_Y Pointer to an integer where the scaled Y value will be stored.
  */
 extern void readAndScaleHardwareJoystick(int* scaled_X, int* scaled_Y);
 
+/**
+* @brief Enables the external interrupt capturing the joystick switch edges.
+* @details Must be called after the switch pin is configured as an input with pull-up.
+*/
+extern void joystickSwitchBegin();
+
 /**
 * @brief Handles joystick button state.
-* @details Implements debounce logic and mode switching.
+* @details Consumes the presses captured and debounced by the switch interrupt, and switches the mode once per press.
 */
 extern void readJoystickSwitch(); 
 
 /**
- * @brief Computes the drive modes and speeds for the left and right motors based on the scaled joystick input.
- * @param scaled_X The scaled X-axis value from the joystick.
- * @param scaled_Y The scaled Y-axis value from the joystick.
- * @details This function resets the motor states, then determines the appropriate drive mode (forward, backward, or stopped) and speed for the left and right motors based on the scaled joystick input. The function uses a series of conditional statements to handle different combinations of X and Y axis values, applying the appropriate scaling and direction logic to compute the motor speeds.
+ * @brief Computes the target drive modes and speeds for the left and right motors based on the scaled joystick input.
+ * @param scaled_X The scaled X-axis value from the joystick (forward / backward).
+ * @param scaled_Y The scaled Y-axis value from the joystick (turn, right if positive).
+ * @details Integer arcade-drive mixer covering the whole (X, Y) plane. The pivot turn mix (wheels in opposite directions) is added to the arc turn mix (inner wheel slowed down)
+ * with a weight depending on the throttle, so that the robot pivots when X is centered and smoothly switches to arc turns up to PIVOT_LIMIT.
  */
 extern void computeDriveModesAndSpeeds(int scaled_X, int scaled_Y);
 
+/**
+ * @brief Prints the output of the former floating-point mixer and of the current mixer over a grid of inputs, with the cycles spent by each call.
+ * @details Regression table used to compare both mixers. Only defined when BENCHMARK_JOYSTICK is enabled.
+ */
+extern void benchmarkDriveMixer();
+
 
 /**
  * @brief Get the name of the specified joystick input.
  * @param joystickInput The joystick input to get the name for.
  * @return The name of the specified joystick input as a String.
  */
-extern char* getJoystickInputName();
+extern const char* getJoystickInputName();
 
@@ -0,0 +1,87 @@
+/**
+ * @file logger.h
+ * @brief Header file containing the deferred binary logging declarations and configurations.
+ * @details Debug events are stored as compact binary records (event id, timestamp and two arguments) in a RAM ring buffer,
+ *          and are only sent on the serial port when the CPU is idle. Nothing is formatted on the robot, the records are turned
+ *          back into text on the computer by Tools/decode_log.py, so debug builds keep the same timing as release builds.
+ */
+
+#pragma once
+
+//=============================================================================
+//                       INCLUDE LIBRARIES AND HEADER FILES
+//=============================================================================
+
+#include "utils.h"
+
+//=============================================================================
+//                              TYPE DECLARATIONS
+//=============================================================================
+
+/**
+ * @brief Enumeration of the logged events.
+ * @details The comment of each event is the format used by Tools/decode_log.py to print it, with the two arguments in order.
+ * @note New events must be added at the end so that old logs can still be decoded.
+ */
+typedef enum logEvent_t {
+    LOG_DROPPED,            /**< %d log records dropped (buffer full) */
+    LOG_INPUT_MODE,         /**< Input mode: %d */
+    LOG_BT_FRAME,           /**< Received joystick frame: X=%d Y=%d */
+    LOG_BT_PREFIX,          /**< * spotted as prefix in BT_process */
+    LOG_BT_WRONG_CRC,       /**< Wrong CRC in binary frame %d */
+    LOG_SCALED_INPUT,       /**< (scaled_X, scaled_Y) = (%d,%d) */
+    LOG_HARDWARE_INPUT,     /**< (X, Y) = (%d,%d) */
+    LOG_SWITCH_PRESSED,     /**< Switch pressed, LED pattern updating to mode %d */
+    LOG_MOTORS_SPEED,       /**< Updated motors speed (L,R): ( %d , %d ) */
+    LOG_MOTORS_MODES,       /**< Updated motors modes (L,R): ( %d , %d ) */
+    LOG_BUZZER_MODE,        /**< Mode in buzzer: %d */
+    LOG_EVENT_COUNT         /**< Number of events */
+} logEvent_t;
+
+/**
+ * @brief Binary log record.
+ */
+typedef struct logRecord_t {
+    uint8_t event;          /**< Event id (logEvent_t) */
+    uint32_t timestamp;     /**< Time of the event (ms) */
+    int16_t args[2];        /**< Arguments of the event */
+} logRecord_t;
+
+//=============================================================================
+//                                   MACROS
+//=============================================================================
+
+/**
+ * @brief Number of records the ring buffer can hold. Must be a power of two.
+ */
+#define LOG_BUFFER_SIZE 32
+
+/**
+ * @brief First byte of a record sent on the serial port.
+ * @details A record is sent as: LOG_MARKER, event id, timestamp (4 bytes), arguments (2 x 2 bytes), XOR of the 9 previous bytes.
+ *          Multi-byte values are little-endian.
+ */
+#define LOG_MARKER 0xFE
+
+/**
+ * @brief Size of a record sent on the serial port.
+ */
+#define LOG_FRAME_SIZE 11
+
+//=============================================================================
+//                           ROUTINE PROTOTYPES
+//=============================================================================
+
+/**
+ * @brief Stores an event in the ring buffer. The event is dropped if the buffer is full.
+ * @param event Event id.
+ * @param arg0 First argument.
+ * @param arg1 Second argument.
+ */
+extern void logEvent(logEvent_t event, int16_t arg0 = 0, int16_t arg1 = 0);
+
+/**
+ * @brief Sends the buffered records on the serial port, without waiting: only the bytes fitting in the serial transmit buffer are written.
+ * @details Must be called when the CPU is idle.
+ */
+extern void logDrain();
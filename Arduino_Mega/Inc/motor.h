@@ -68,15 +68,65 @@ typedef enum driveMode_t {
 #define FULL_SPEED 150
 
 /**
- * @brief Scaling factor used to map the default position range to the full motor speed range.
+ * @brief Scaling factor used to map the default position range to the full motor speed range, in Q8 fixed-point.
+ * @details motor speed = (|position| * MOTOR_SCALE_Q8) >> 8, which avoids a floating-point division on the AVR.
  */
-#define MOTOR_SCALING_FACTOR ((float)DEFAULT_POSITION / FULL_SPEED)
+#define MOTOR_SCALE_Q8 ((FULL_SPEED * 256UL) / DEFAULT_POSITION)
+
+/**
+ * @brief Prescaler of Timer2 and Timer3, which generate the PWM of EN_A and EN_B. Sets the PWM carrier frequency of the L298N.
+ * @details Phase-correct 8-bit PWM, f = 16 MHz / (510 * MOTOR_PWM_PRESCALER). Supported values, available on both timers:
+ *          1 (31.4 kHz), 8 (3.9 kHz) and 64 (490 Hz, the Arduino default).
+ */
+#define MOTOR_PWM_PRESCALER 64
+
+/**
+ * @brief Period of the motor control stage (µs), i.e. of the motor task.
+ */
+#define MOTOR_CONTROL_PERIOD 10000
+
+/**
+ * @brief Maximum acceleration of a motor, in PWM units per second.
+ * @details Limits the current drawn when speeding up, which can reset the board through a brownout on the 9 V battery.
+ */
+#define MOTOR_ACCELERATION 500
+
+/**
+ * @brief Maximum deceleration of a motor, in PWM units per second.
+ */
+#define MOTOR_DECELERATION 1000
+
+/**
+ * @brief Maximum speed change of a motor per control period, when speeding up and when slowing down.
+ */
+#define MOTOR_ACCELERATION_STEP ((uint8_t)((MOTOR_ACCELERATION * (unsigned long)MOTOR_CONTROL_PERIOD) / 1000000UL))
+#define MOTOR_DECELERATION_STEP ((uint8_t)((MOTOR_DECELERATION * (unsigned long)MOTOR_CONTROL_PERIOD) / 1000000UL))
 
 //=============================================================================
 //                             VARIABLE DECLARATIONS
 //=============================================================================
 
 
+/**
+ * @brief Left motor target speed, set by the joystick mixer.
+ */
+extern uint8_t targetSpeedL;
+
+/**
+ * @brief Right motor target speed, set by the joystick mixer.
+ */
+extern uint8_t targetSpeedR;
+
+/**
+ * @brief Left motor target drive mode, set by the joystick mixer.
+ */
+extern driveMode_t targetDriveModeL;
+
+/**
+ * @brief Right motor target drive mode, set by the joystick mixer.
+ */
+extern driveMode_t targetDriveModeR;
+
 /**
  * @brief Left motor speed.
  */
@@ -102,10 +152,24 @@ extern driveMode_t driveModeR;
 //=============================================================================
 
 /**
- * @brief Resets both motor states to default values (switched-off).
+ * @brief Configures the PWM timers of the enable pins and forces the next settings to be written to the outputs.
+ * @details Must be called after the motor pins are configured as outputs.
+ * @note Timer2 and Timer3 are dedicated to the motors, their other PWM pins (2, 3 and 9) must not be used with analogWrite().
+ */
+void motorOutputBegin();
+
+/**
+ * @brief Resets both motor states and targets to default values (switched-off).
  */
 void resetMotorStates();
 
+/**
+ * @brief Moves the motor speeds and drive modes one control period toward their targets.
+ * @details Must be called every MOTOR_CONTROL_PERIOD. The speeds change by at most MOTOR_ACCELERATION_STEP when speeding up
+ *          and MOTOR_DECELERATION_STEP when slowing down. A motor reversing its direction is slowed down to STOPPED first.
+ */
+void updateMotorsRamp();
+
 /**
  * @brief Applies current speed settings to both motors.
  */
@@ -126,4 +190,4 @@ void applyMotorsSettings();
  * @param direction The drive mode to convert.
  * @return Corresponding direction name.
  */
-char* getDirectionName(driveMode_t direction);
+const char* getDirectionName(driveMode_t direction);
@@ -0,0 +1,132 @@
+/**
+ * @file profiler.h
+ * @brief Header file containing the timing instrumentation declarations and macros.
+ * @details Measures the time spent in each subsystem and the loop period with micros(), and keeps for each of them
+ *          the minimum, maximum, mean and a log2-bucketed histogram. The statistics are printed on the serial port on demand.
+ *          Everything compiles out when PROFILE_TIMING is not defined.
+ */
+
+#pragma once
+
+//=============================================================================
+//                       INCLUDE LIBRARIES AND HEADER FILES
+//=============================================================================
+
+#include "utils.h"
+
+//=============================================================================
+//                              TYPE DECLARATIONS
+//=============================================================================
+
+/**
+ * @brief Enumeration of the measured subsystems.
+ */
+typedef enum profileId_t {
+    PROFILE_LOOP,       /**< Period of the main loop */
+    PROFILE_INPUT,      /**< Joystick input task, Bluetooth decoding included */
+    PROFILE_BT,         /**< BT_process() */
+    PROFILE_MOTORS,     /**< Motor task */
+    PROFILE_LED,        /**< LED task, frame computation and transmission included */
+    PROFILE_LED_SHOW,   /**< pixels.show() */
+    PROFILE_BUZZER,     /**< Buzzer task */
+    PROFILE_LATENCY,    /**< Input to actuation: from the reception of a command to the next motor output update */
+    PROFILE_COUNT       /**< Number of measured subsystems */
+} profileId_t;
+
+//=============================================================================
+//                                   MACROS
+//=============================================================================
+
+/**
+ * @brief Number of buckets of the histograms. Bucket i counts the durations of i significant bits, i.e. in [2^(i-1); 2^i[ µs.
+ * @details The last bucket also counts all the longer durations.
+ */
+#define PROFILE_BUCKETS 16
+
+/**
+ * @brief Character to send on the serial port to print the statistics.
+ */
+#define PROFILE_DUMP_REQUEST 'p'
+
+/**
+ * @brief Highest acceptable 99th percentile of the input to actuation latency (µs).
+ * @details The statistics dump reports a failure when the 99th percentile may exceed it, so that a change can be checked against it.
+ *          The percentiles are only known to the bound of their histogram bucket, so the limit must be a power of two to be checked exactly.
+ */
+#define PROFILE_LATENCY_LIMIT 16384
+
+#if (PROFILE_LATENCY_LIMIT & (PROFILE_LATENCY_LIMIT - 1))
+#error "PROFILE_LATENCY_LIMIT must be a power of two, the upper bound of a histogram bucket"
+#endif
+
+#ifdef PROFILE_TIMING
+
+/**
+ * @brief Starts measuring the duration of a subsystem call.
+ */
+#define PROFILE_START(id) unsigned long profileStart_##id = micros()
+
+/**
+ * @brief Stops measuring the duration of a subsystem call and records it.
+ */
+#define PROFILE_STOP(id) profileRecord((id), micros() - profileStart_##id)
+
+/**
+ * @brief Records the time elapsed since the previous call at the same place, e.g. the loop period.
+ */
+#define PROFILE_PERIOD(id) do { \
+        static unsigned long profileLast_##id = 0; \
+        unsigned long profileNow = micros(); \
+        if (profileLast_##id != 0) profileRecord((id), profileNow - profileLast_##id); \
+        profileLast_##id = profileNow; \
+    } while (0)
+
+/**
+ * @brief Starts measuring a span that ends in another routine, from the given time (µs). Ignored if a span of the same id is pending.
+ */
+#define PROFILE_SPAN_START(id, time) profileSpanStart((id), (time))
+
+/**
+ * @brief Stops measuring a span and records its duration, if one is pending.
+ */
+#define PROFILE_SPAN_STOP(id) profileSpanStop(id)
+
+#else
+
+#define PROFILE_START(id)
+#define PROFILE_STOP(id)
+#define PROFILE_PERIOD(id)
+#define PROFILE_SPAN_START(id, time)
+#define PROFILE_SPAN_STOP(id)
+
+#endif
+
+//=============================================================================
+//                           ROUTINE PROTOTYPES
+//=============================================================================
+
+/**
+ * @brief Records one measured duration of a subsystem.
+ * @param id Measured subsystem.
+ * @param duration Measured duration (µs).
+ */
+extern void profileRecord(profileId_t id, unsigned long duration);
+
+/**
+ * @brief Starts measuring a span that ends in another routine. Ignored if a span of the same id is pending.
+ * @param id Measured span.
+ * @param start Start time of the span (µs).
+ */
+extern void profileSpanStart(profileId_t id, unsigned long start);
+
+/**
+ * @brief Stops measuring a span and records its duration, if one is pending.
+ * @param id Measured span.
+ */
+extern void profileSpanStop(profileId_t id);
+
+/**
+ * @brief Prints the statistics of every subsystem on the serial port, then resets them.
+ * @details The 50th and 99th percentiles are given as the upper bound of their histogram bucket.
+ */
+extern void profileDump();
@@ -0,0 +1,81 @@
+/**
+ * @file scheduler.h
+ * @brief Header file containing the cooperative task scheduler declarations and configurations.
+ * @details Each subsystem is a task of a static table with a period and a time budget.
+ *          The scheduler runs the ready tasks at a fixed rate, detects the overruns and lets the CPU idle when no task is ready.
+ */
+
+#pragma once
+
+//=============================================================================
+//                       INCLUDE LIBRARIES AND HEADER FILES
+//=============================================================================
+
+#include "utils.h"
+
+#include "profiler.h"
+
+//=============================================================================
+//                              TYPE DECLARATIONS
+//=============================================================================
+
+/**
+ * @brief Task of the cooperative scheduler.
+ */
+typedef struct task_t {
+    const char* name;             /**< Name of the task, for debugging output */
+    void (*run)();                /**< Routine called each period, must return quickly */
+    unsigned long period;         /**< Period of the task (µs) */
+    unsigned long budget;         /**< Maximum expected duration of one run (µs) */
+    unsigned long nextRun;        /**< Time of the next run (µs), updated by the scheduler */
+    unsigned long maxDuration;    /**< Longest run measured (µs) */
+    uint16_t budgetOverruns;      /**< Number of runs that exceeded the budget */
+    uint16_t missedPeriods;       /**< Number of runs started more than one period late */
+} task_t;
+
+//=============================================================================
+//                                   MACROS
+//=============================================================================
+
+/**
+ * @brief Builds a task table entry from its name, routine, period (µs) and budget (µs).
+ */
+#define TASK(name, run, period, budget) { (name), (run), (period), (budget), 0, 0, 0, 0 }
+
+/**
+ * @brief Number of entries of a static task table.
+ */
+#define TASK_COUNT(tasks) (sizeof(tasks) / sizeof(task_t))
+
+//=============================================================================
+//                           ROUTINE PROTOTYPES
+//=============================================================================
+
+/**
+ * @brief Schedules the first run of every task of the table.
+ * @param tasks Static task table.
+ * @param count Number of tasks in the table.
+ */
+extern void schedulerBegin(task_t* tasks, uint8_t count);
+
+/**
+ * @brief Runs the most overdue ready task of the table.
+ * @param tasks Static task table.
+ * @param count Number of tasks in the table.
+ * @return True if a task was run, false if no task is ready and the CPU can do background work or idle.
+ * @details Only one task is run per call, always the one with the earliest release time, so that a task can't starve the others.
+ *          A task late by more than one period is rescheduled from now instead of running several times in a row.
+ */
+extern bool schedulerRun(task_t* tasks, uint8_t count);
+
+/**
+ * @brief Idles the CPU until the next interrupt (at most about 1 ms with the millis() timer).
+ */
+extern void schedulerIdle();
+
+/**
+ * @brief Prints the statistics of every task on the serial port.
+ * @param tasks Static task table.
+ * @param count Number of tasks in the table.
+ */
+extern void schedulerPrintStats(const task_t* tasks, uint8_t count);
@@ -38,6 +38,17 @@
 */
 typedef unsigned int uint;
 
+/**
+* @brief Descriptor of an LED pattern, stored in flash in the ledPatterns registry.
+*/
+typedef struct ledPattern_t {
+    const uint8_t (*palette)[3];   /**< RGB colors repeated along the strip, stored in flash, NULL for the generated rainbow */
+    uint8_t length;                /**< Number of colors of the palette */
+    uint16_t period;               /**< Time between two shifts of the colors along the strip (ms), 0 for a static pattern */
+    int8_t song;                   /**< Music played by the buzzer in this mode (songId_t), NO_SONG for none */
+    char name[26];                 /**< Name of the pattern, 25 characters at most */
+} ledPattern_t;
+
 //=============================================================================
 //                                   MACROS
 //=============================================================================
@@ -53,48 +64,110 @@ typedef unsigned int uint;
 #define NUM_PIXELS 64
 
 /**
-* @brief Number of LED in the default pattern.
+* @brief Sends the strip in segments, with the interrupts enabled between them (see ChunkedNeoPixel).
+* This macro can be uncommented so that the Bluetooth UART does not lose bytes while a frame is sent to the strip.
+*/
+// #define STRIP_CHUNKED_OUTPUT
+
+/**
+* @brief Number of pixels sent per segment when STRIP_CHUNKED_OUTPUT is enabled.
+* @details A pixel takes 30 µs to send. The interrupts are disabled for a segment, and the UART can only hold 2 received bytes
+*          (347 µs at 57600 baud) before losing the next ones: 8 pixels (240 µs) leave room for the rest of the transmission setup.
+*/
+#define STRIP_CHUNK_PIXELS 8
+
+/**
+* @brief Builds an entry of the pattern registry from a palette, a shift period (ms, 0 for static), a song (songId_t or NO_SONG) and a name.
+* @details The length of the palette is computed at compile time.
+*/
+#define LED_PATTERN(palette, period, song, name) { (palette), sizeof(palette) / sizeof((palette)[0]), (period), (song), name }
+
+/**
+* @brief Song of the modes without music.
+*/
+#define NO_SONG -1
+
+/**
+* @brief Time between two shifts of the dynamic patterns (ms).
 */
-#define n_LED1 4  
+#define LED_DYNAMIC_PERIOD 100
 
 /**
-* @brief Number of LED in the Italy pattern.
+* @brief Hue difference between two neighbouring pixels of the rainbow, on 8 bits (256 is a full turn of the color wheel).
+* @details With 4, the 64 pixels of the strip show exactly one full rainbow.
 */
-#define n_LED2 3
+#define RAINBOW_HUE_SPACING 4
 
 /**
-* @brief Number of LED in the France pattern.
+* @brief Rotation speed of the rainbow, in 1/256 of hue unit per millisecond (about 1.5 turns of the color wheel per second with 100).
 */
-#define n_LED3 3  
+#define RAINBOW_HUE_SPEED 100
 
 /**
-* @brief Number of LED in the rainbow pattern.
+* @brief Breathing speed of the rainbow, in 1/256 of fade unit per millisecond (about one breath every 2.6 s with 25).
 */
-#define n_LED4 7
+#define RAINBOW_FADE_SPEED 25
+
+/**
+* @brief Lowest fade level of the breathing, on 8 bits, so that the strip never goes completely dark.
+*/
+#define RAINBOW_MIN_FADE 128
+
+/**
+* @brief Brightest level of the rainbow, on 8 bits, close to the brightest patterns.
+*/
+#define RAINBOW_MAX_LEVEL 100
 
 //=============================================================================
-//                            VARIABLE DECLARATIONS
+//                              CLASS DECLARATIONS
 //=============================================================================
 
 /**
-* @brief RGB color values for default pattern.
+* @brief NeoPixel strip sent in segments of STRIP_CHUNK_PIXELS pixels, servicing the pending interrupts between them.
+* @details Adafruit_NeoPixel::show() disables the interrupts for the whole strip, about 1.9 ms for 64 pixels,
+*          during which the Bluetooth UART overruns. The strip only latches the data after the line stays low for its reset time
+*          (80 µs for the SK6812), so the segments make up a single frame as long as the interrupts serviced between them are short.
+*          Each segment is sent by the library routine itself, so the bit timings are unchanged.
 */
-extern const uint RGB_values1[n_LED1][3]; 
+class ChunkedNeoPixel : public Adafruit_NeoPixel {
+    public:
+        using Adafruit_NeoPixel::Adafruit_NeoPixel;
+
+        /**
+         * @brief Sends the pixel colors to the strip, one segment at a time.
+         */
+        void show();
+};
 
 /**
-* @brief RGB color values for Italy pattern.
+* @brief Driver of the LED strip, selected by STRIP_CHUNKED_OUTPUT.
 */
-extern const uint RGB_values2[n_LED2][3];
+#ifdef STRIP_CHUNKED_OUTPUT
+typedef ChunkedNeoPixel stripDriver_t;
+#else
+typedef Adafruit_NeoPixel stripDriver_t;
+#endif
+
+//=============================================================================
+//                            VARIABLE DECLARATIONS
+//=============================================================================
 
 /**
-* @brief RGB color values for France pattern.
+* @brief Registry of the LED patterns, indexed by mode, stored in flash.
+* @note Must be read with pgm_read_byte(), pgm_read_word() or pgm_read_ptr().
 */
-extern const uint RGB_values3[n_LED3][3];
+extern const ledPattern_t ledPatterns[] PROGMEM;
 
 /**
-* @brief RGB color values for rainbow pattern.
+* @brief Number of entries of the pattern registry, i.e. of modes.
 */
-extern const uint RGB_values4[n_LED4][3];
+extern const uint8_t ledPatternCount;
+
+/**
+* @brief Gamma correction table (gamma 2.6), from linear 8-bit intensities to LED PWM values, stored in flash.
+* @note Must be read with pgm_read_byte().
+*/
+extern const uint8_t gamma8[256] PROGMEM;
 
 /**
 * @brief Current operating mode for LED and buzzer.
@@ -107,7 +180,8 @@ extern const uint RGB_values4[n_LED4][3];
 *   - 5: Italy dynamic, Nokia ringtone
 *   - 6: France dynamic, Subway Surfers theme
 *   - 7: Rainbow dynamic, The Simpsons theme
-*   - 8: LED off
+*   - 8: Rainbow dynamic and faded, no music
+*   There is one mode per entry of ledPatterns.
 *  
 */
 extern int mode;
@@ -115,7 +189,17 @@ extern int mode;
 /**
 * @brief NeoPixel strip controller instance.
 */
-extern Adafruit_NeoPixel pixels;
+extern stripDriver_t pixels;
+
+/**
+* @brief Number of frames sent to the LED strip.
+*/
+extern unsigned long ledFramesPushed;
+
+/**
+* @brief Number of frames skipped because they were identical to the last frame sent.
+*/
+extern unsigned long ledFramesSkipped;
 
 //=============================================================================
 //                           ROUTINE PROTOTYPES
@@ -125,23 +209,37 @@ extern Adafruit_NeoPixel pixels;
  * @brief Updates the LED display based on the current mode.
  * 
  * This function handles the logic for updating the LED display. 
- * It clears the NeoPixel strip, applies timing control for dynamic modes, and then sets the
- * pixel colors based on the current display mode. 
- * The procedure supports four different patterns: default, Italy, France, and rainbow. 
- * It also handles both static and dynamic modes.
+ * It applies timing control for dynamic modes, and then, if the frame changed, clears the NeoPixel strip,
+ * sets the pixel colors based on the current display mode and sends them to the strip.
+ * The pattern of the current mode is read from the ledPatterns registry: a palette shifted every period (static if 0),
+ * or the generated rainbow.
+ * Identical frames are neither computed nor sent, see ledFramesPushed and ledFramesSkipped.
  */
 extern void updateLED_Display();
 
 /**
- * @brief Retrieves the size of the LED pattern based on the current display mode.
- * @param mode The current display mode number.
- * @return The size of the LED pattern for the given mode.
+ * @brief Sets the color of every pixel of the strip for a mode, without sending them to the strip.
+ * @param mode Display mode, in [0; ledPatternCount[.
+ * @param offset Index of the palette color of the first pixel, ignored by the rainbow.
+ * @param elapsed Time elapsed since the previous frame (ms), only used by the rainbow.
  */
-extern int getPatternSize(int mode);
+extern void renderLED_Frame(int mode, uint8_t offset, unsigned long elapsed);
 
 /**
 * @brief Retrieves the name of the current pattern.
 * @param mode Current display mode number.
-* @return Name of the active pattern.
+* @return Name of the active pattern, stored in flash.
+*/
+extern const __FlashStringHelper* getPatternName(int mode);
+
+/**
+* @brief Prints the number of frames sent to the strip and skipped since startup on the serial port.
 */
-extern char* getPatternName(int mode);
\ No newline at end of file
+extern void LED_printStats();
+
+/**
+ * @brief Measures the cycles spent computing one frame with the modulo render path and with the wrapping render path.
+ * @details The results are printed on the serial port for the modes 0 to 7. Nothing is sent to the strip.
+ *          Only defined when BENCHMARK_STRIP_LED is enabled.
+ */
+extern void benchmarkLED_Display();
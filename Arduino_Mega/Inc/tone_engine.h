@@ -0,0 +1,147 @@
+/**
+ * @file tone_engine.h
+ * @brief Header file containing the timer-interrupt tone engine declarations and configurations.
+ * @details The tone engine drives the buzzer from the Timer1 compare match interrupt. The main loop only feeds a small
+ *          lock-free queue of note segments, the note-on, note-off and the silence between notes are handled inside the ISR
+ *          so the music timing does not depend on the main loop load.
+ */
+
+#pragma once
+
+//=============================================================================
+//                       INCLUDE LIBRARIES AND HEADER FILES
+//=============================================================================
+
+/**
+ * @brief Includes the 'pitches.h' header file.
+ * @details This header file provides definitions for common musical note frequencies, used to build the pitch table.
+ */
+#include <pitches.h>
+
+#include "utils.h"
+
+//=============================================================================
+//                              TYPE DECLARATIONS
+//=============================================================================
+
+/**
+ * @brief Index of every pitch of pitches.h in pitch_tab, sorted by frequency.
+ * @details Songs store these one-byte indexes instead of the 16-bit frequencies.
+ */
+typedef enum pitchIndex_t {
+    PITCH_REST,  /**< Silence */
+    PITCH_B0, PITCH_C1, PITCH_CS1, PITCH_D1, PITCH_DS1, PITCH_E1, PITCH_F1, PITCH_FS1,
+    PITCH_G1, PITCH_GS1, PITCH_A1, PITCH_AS1, PITCH_B1, PITCH_C2, PITCH_CS2, PITCH_D2,
+    PITCH_DS2, PITCH_E2, PITCH_F2, PITCH_FS2, PITCH_G2, PITCH_GS2, PITCH_A2, PITCH_AS2,
+    PITCH_B2, PITCH_C3, PITCH_CS3, PITCH_D3, PITCH_DS3, PITCH_E3, PITCH_F3, PITCH_FS3,
+    PITCH_G3, PITCH_GS3, PITCH_A3, PITCH_AS3, PITCH_B3, PITCH_C4, PITCH_CS4, PITCH_D4,
+    PITCH_DS4, PITCH_E4, PITCH_F4, PITCH_FS4, PITCH_G4, PITCH_GS4, PITCH_A4, PITCH_AS4,
+    PITCH_B4, PITCH_C5, PITCH_CS5, PITCH_D5, PITCH_DS5, PITCH_E5, PITCH_F5, PITCH_FS5,
+    PITCH_G5, PITCH_GS5, PITCH_A5, PITCH_AS5, PITCH_B5, PITCH_C6, PITCH_CS6, PITCH_D6,
+    PITCH_DS6, PITCH_E6, PITCH_F6, PITCH_FS6, PITCH_G6, PITCH_GS6, PITCH_A6, PITCH_AS6,
+    PITCH_B6, PITCH_C7, PITCH_CS7, PITCH_D7, PITCH_DS7, PITCH_E7, PITCH_F7, PITCH_FS7,
+    PITCH_G7, PITCH_GS7, PITCH_A7, PITCH_AS7, PITCH_B7, PITCH_C8, PITCH_CS8, PITCH_D8,
+    PITCH_DS8,
+    PITCH_COUNT  /**< Number of entries in pitch_tab */
+} pitchIndex_t;
+
+/**
+ * @brief Precomputed timer values for one pitch.
+ */
+typedef struct pitch_t {
+    uint16_t frequency;     /**< Frequency of the note (Hz), as defined in pitches.h, REST for a silence */
+    uint16_t compare;       /**< Timer1 compare value toggling the buzzer pin at twice the frequency */
+    uint16_t togglesPerMs;  /**< Number of pin toggles per millisecond, Q8 fixed-point */
+} pitch_t;
+
+/**
+ * @brief One segment of sound or silence consumed by the tone engine ISR.
+ */
+typedef struct toneSegment_t {
+    uint16_t compare;   /**< Timer1 compare value used during the segment */
+    uint16_t ticks;     /**< Number of compare match interrupts the segment lasts */
+    bool sounding;      /**< True if the buzzer pin is toggled during the segment */
+} toneSegment_t;
+
+//=============================================================================
+//                                   MACROS
+//=============================================================================
+
+/**
+ * @brief Output port register of the buzzer pin (digital pin 2 is PE4 on the Mega).
+ * @note Must match BUZZER_PIN.
+ */
+#define BUZZER_PORT PORTE
+
+/**
+ * @brief Input port register of the buzzer pin. Writing a one to it toggles the output.
+ */
+#define BUZZER_PIN_REG PINE
+
+/**
+ * @brief Bit of the buzzer pin in its port registers.
+ */
+#define BUZZER_BIT PE4
+
+/**
+ * @brief Timer1 prescaler used by the tone engine.
+ */
+#define TONE_PRESCALER 8
+
+/**
+ * @brief Computes the Timer1 CTC compare value toggling the pin at twice the given frequency.
+ */
+#define TONE_COMPARE(frequency) ((uint16_t)(F_CPU / (2UL * TONE_PRESCALER * (frequency)) - 1))
+
+/**
+ * @brief Computes the number of pin toggles per millisecond for the given frequency, in Q8 fixed-point.
+ */
+#define TONE_TOGGLES_PER_MS(frequency) ((uint16_t)((2UL * 256 * (frequency) + 500) / 1000))
+
+/**
+ * @brief Compare value giving a 1 ms tick, used to time rests and gaps between notes.
+ */
+#define SILENCE_COMPARE ((uint16_t)(F_CPU / (1000UL * TONE_PRESCALER) - 1))
+
+/**
+ * @brief Number of segments the queue can hold. Must be a power of two.
+ */
+#define TONE_QUEUE_SIZE 8
+
+//=============================================================================
+//                             VARIABLE DECLARATIONS
+//=============================================================================
+
+/**
+ * @brief Precomputed timer values for every pitch of pitches.h, indexed by pitchIndex_t and stored in flash.
+ */
+extern const pitch_t pitch_tab[PITCH_COUNT] PROGMEM;
+
+//=============================================================================
+//                           ROUTINE PROTOTYPES
+//=============================================================================
+
+/**
+ * @brief Configures Timer1 for the tone engine. The timer interrupt stays disabled until a segment is queued.
+ */
+extern void toneEngineBegin();
+
+/**
+ * @brief Stops the sound immediately and empties the queue.
+ */
+extern void toneEngineStop();
+
+/**
+ * @brief Queues a note followed by the silence distinguishing it from the next one.
+ * @param pitch Index of the note in pitch_tab, PITCH_REST for a silent note.
+ * @param duration Duration of the note (ms).
+ * @param gap Duration of the silence after the note (ms).
+ * @return True if the note was queued, false if the queue is full.
+ */
+extern bool toneEnginePushNote(uint8_t pitch, uint16_t duration, uint16_t gap);
+
+/**
+ * @brief Gets the number of free segments in the queue.
+ * @return Number of segments that can still be queued.
+ */
+extern uint8_t toneEngineFreeSlots();
@@ -48,13 +48,43 @@
  * @brief Enables debugging output for Bluetooth.
  * This macro can be uncommented to enable additional debugging output related to Bluetooth operations.
  */
-#define DEBUG_BT
+// #define DEBUG_BT
 
 /**
  * @brief Enables debugging output for buzzer.
  * This macro can be uncommented to enable additional debugging output related to the buzzer operations.
  */
-#define DEBUG_BUZZER
+// #define DEBUG_BUZZER
+
+/**
+ * @brief Enables the LED strip render benchmark, run once at startup.
+ * This macro can be uncommented to print the cycles spent computing a frame for each LED mode.
+ */
+// #define BENCHMARK_STRIP_LED
+
+/**
+ * @brief Enables the drive mixer benchmark, run once at startup.
+ * This macro can be uncommented to print the regression table and the cycles of the former and current drive mixers.
+ */
+// #define BENCHMARK_JOYSTICK
+
+/**
+ * @brief Enables the Bluetooth decoder benchmark, run once at startup.
+ * This macro can be uncommented to feed generated, mutated and random streams to BT_process() and print its throughput and robustness checks.
+ */
+// #define BENCHMARK_BT
+
+/**
+ * @brief Enables the cycle count benchmark of the hot functions, run once at startup.
+ * This macro can be uncommented to print the exact cycles spent in the LED, mixer, parsing and buzzer functions, to be compared with Tools/cycles_baseline.txt.
+ */
+// #define BENCHMARK_CYCLES
+
+/**
+ * @brief Enables the timing instrumentation of the main loop and of each subsystem.
+ * This macro can be uncommented to measure the loop period and the subsystems durations. Send 'p' on the serial port to print the statistics.
+ */
+// #define PROFILE_TIMING
 
 //=============================================================================
 //                              VARIABLE DECLARATIONS
@@ -70,7 +100,7 @@ extern Bonezegei_Printf debug;
 //=============================================================================
 
 /**
-* @brief Changes the current LED and buzzer mode. Mode values range from 0 to 8.
+* @brief Changes the current LED and buzzer mode. Mode values range from 0 to ledPatternCount - 1.
 */
 extern void updateMode();
 
@@ -79,4 +109,16 @@ extern void updateMode();
 * @param i Input integer value.
 * @return Converted unsigned 8-bit integer value.
 */
-extern uint8_t intToUint8_t(int integer_value);
\ No newline at end of file
+extern uint8_t intToUint8_t(int integer_value);
+
+/**
+* @brief Resets and starts the cycle counter (Timer5, no prescaler).
+* @note Timer5 is dedicated to the cycle counter, its PWM pins (44 to 46) must not be used.
+*/
+extern void startCycleCounter();
+
+/**
+* @brief Reads the number of CPU cycles elapsed since startCycleCounter().
+* @return Number of elapsed CPU cycles.
+*/
+extern uint32_t readCycleCounter();
@@ -0,0 +1,150 @@
+/**
+ * @file benchmark.cpp
+ * @brief Source file containing the cycle count benchmark implementation.
+ * @details Only compiled in when BENCHMARK_CYCLES is defined.
+ */
+
+//=============================================================================
+//                       INCLUDE LIBRARIES AND HEADER FILES
+//=============================================================================
+
+#include "../Inc/benchmark.h"
+
+#include "../Inc/joystick.h"
+
+#include "../Inc/tone_engine.h"
+
+#ifdef BENCHMARK_CYCLES
+
+//=============================================================================
+//                                   MACROS
+//=============================================================================
+
+/**
+ * @brief Measures the cycles spent in a statement, without the overhead of the cycle counter itself.
+ * @details The interrupts are disabled so that the count is exact and repeatable: the serial transmission is completed first,
+ *          and the statement must not wait for an interrupt. The cycle counter handles one overflow with the interrupts disabled,
+ *          so the statement must take less than 131072 cycles (8 ms).
+ */
+#define MEASURE_CYCLES(cycles, statement) do { \
+        Serial.flush(); \
+        uint8_t oldSREG = SREG; \
+        cli(); \
+        startCycleCounter(); \
+        statement; \
+        (cycles) = readCycleCounter() - cycleCounterOverhead; \
+        SREG = oldSREG; \
+    } while (0)
+
+//=============================================================================
+//                             VARIABLE DEFINITIONS
+//=============================================================================
+
+/**
+ * @brief Cycles measured for an empty statement, subtracted from every measure.
+ */
+static uint32_t cycleCounterOverhead = 0;
+
+/**
+ * @brief Frames given to parseValue(): legal, largest, missing and too long values.
+ */
+static const char* const parseValueCases[] = { "X12,Y200", "X255,Y255", "X,Y", "X1234,Y5" };
+
+/**
+ * @brief Inputs given to intToUint8_t(): below, inside and above [0; 255].
+ */
+static const int intToUint8Cases[] = { -1000, 0, 128, 1000 };
+
+//=============================================================================
+//                             ROUTINE DEFINITIONS
+//=============================================================================
+
+/**
+ * @brief Prints one measure in the format read by Tools/compare_cycles.py.
+ * @param function Name of the measured function.
+ * @param testCase Name of the case, without spaces.
+ * @param cycles Measured cycles.
+ */
+static void printCycles(const __FlashStringHelper* function, const char* testCase, uint32_t cycles) {
+    Serial.print(F("cycles "));
+    Serial.print(function);
+    Serial.print(' ');
+    Serial.print(testCase);
+    Serial.print(' ');
+    Serial.println(cycles);
+}
+
+/**
+ * @brief Prints one measure of a case identified by a number.
+ * @param function Name of the measured function.
+ * @param testCase Number of the case.
+ * @param cycles Measured cycles.
+ */
+static void printCycles(const __FlashStringHelper* function, int testCase, uint32_t cycles) {
+    char name[8];
+    itoa(testCase, name, 10);
+    printCycles(function, name, cycles);
+}
+
+/**
+ * @brief Prints the cycles spent computing an LED frame (renderLED_Frame()) for each mode, in computeDriveModesAndSpeeds() over a grid of positions,
+ *        in parseValue(), intToUint8_t() and in the first buzz() call of each song.
+ * @details Must be called at the end of setup(), once the strip is initialized. The mode, the motor targets and the tone engine are restored afterwards.
+ */
+void benchmarkCycles() {
+    uint32_t cycles;
+    int savedMode = mode;
+
+    MEASURE_CYCLES(cycleCounterOverhead, );
+
+    // Computation of a frame only: pixels.show() enables the interrupts again, and always takes 30 µs per pixel.
+    // The rainbow is advanced by one LED task period.
+    for (int benchMode = 0; benchMode < ledPatternCount; benchMode++) {
+        MEASURE_CYCLES(cycles, renderLED_Frame(benchMode, 0, 16));
+        printCycles(F("renderLED_Frame"), benchMode, cycles);
+    }
+
+    pixels.clear();
+
+    // Mixer: total and worst case over the grid, the per-position outputs are checked by BENCHMARK_JOYSTICK
+    uint32_t totalCycles = 0;
+    uint32_t maxCycles = 0;
+
+    for (int X = -DEFAULT_POSITION; X <= DEFAULT_POSITION; X += BENCHMARK_MIXER_STEP) {
+        for (int Y = -DEFAULT_POSITION; Y <= DEFAULT_POSITION; Y += BENCHMARK_MIXER_STEP) {
+            MEASURE_CYCLES(cycles, computeDriveModesAndSpeeds(X, Y));
+            totalCycles += cycles;
+            maxCycles = max(maxCycles, cycles);
+        }
+    }
+
+    printCycles(F("computeDriveModesAndSpeeds"), "grid_total", totalCycles);
+    printCycles(F("computeDriveModesAndSpeeds"), "grid_max", maxCycles);
+
+    // The result is kept in a volatile variable so that the call is not optimized out
+    volatile int result;
+
+    for (uint8_t i = 0; i < sizeof(parseValueCases) / sizeof(parseValueCases[0]); i++) {
+        MEASURE_CYCLES(cycles, result = parseValue(parseValueCases[i], 'Y'));
+        printCycles(F("parseValue"), parseValueCases[i], cycles);
+    }
+
+    for (uint8_t i = 0; i < sizeof(intToUint8Cases) / sizeof(intToUint8Cases[0]); i++) {
+        MEASURE_CYCLES(cycles, result = intToUint8_t(intToUint8Cases[i]));
+        printCycles(F("intToUint8_t"), intToUint8Cases[i], cycles);
+    }
+
+    (void)result;
+
+    // First call after a mode change: the queue is flushed and filled with the first notes of the song. The first modes play each song once.
+    for (mode = 0; mode < SONG_COUNT; mode++) {
+        MEASURE_CYCLES(cycles, buzz());
+        printCycles(F("buzz"), mode, cycles);
+    }
+
+    toneEngineStop();
+    resetMotorStates();
+    mode = savedMode;
+}
+
+#endif
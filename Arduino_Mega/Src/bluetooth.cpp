@@ -8,22 +8,299 @@
 //                       INCLUDE LIBRARIES AND HEADER FILES
 //=============================================================================
 
+// Before Arduino.h, whose min() and max() macros break the C++ library headers
+#if defined(BENCHMARK_BT) && defined(HOST_SIMULATION)
+#include <host.h>
+#endif
+
 #include "../Inc/bluetooth.h"
 
+#include "../Inc/logger.h"
+
+//=============================================================================
+//                                   MACROS
+//=============================================================================
+
+/**
+ * @brief Registers and interrupt vectors of the selected Bluetooth UART.
+ * @note The bit positions are the same for all the UARTs, so the UART 1 bit names are used for both.
+ */
+#if BT_UART == 1
+#define BT_UCSRA UCSR1A
+#define BT_UCSRB UCSR1B
+#define BT_UCSRC UCSR1C
+#define BT_UBRR UBRR1
+#define BT_UDR UDR1
+#define BT_RX_vect USART1_RX_vect
+#elif BT_UART == 2
+#define BT_UCSRA UCSR2A
+#define BT_UCSRB UCSR2B
+#define BT_UCSRC UCSR2C
+#define BT_UBRR UBRR2
+#define BT_UDR UDR2
+#define BT_RX_vect USART2_RX_vect
+#else
+#error "BT_UART must be 1 or 2"
+#endif
+
+#if (BT_RX_BUFFER_SIZE & (BT_RX_BUFFER_SIZE - 1)) || BT_RX_BUFFER_SIZE > 256
+#error "BT_RX_BUFFER_SIZE must be a power of two, 256 at most"
+#endif
+
 //=============================================================================
 //                             VARIABLE DEFINITIONS
 //=============================================================================
 
 /**
-* @brief SoftwareSerial instance for the Bluetooth module.
+* @brief Hardware UART instance for the Bluetooth module.
 */
-SoftwareSerial BlueT(RX, TX);
+BluetoothUart BlueT;
+
+/**
+* @brief Quality statistics of the Bluetooth control link, updated by BT_process() and BT_checkTimeout().
+*/
+btLinkStats_t btLinkStats;
+
+/**
+ * @brief Receive ring buffer of the Bluetooth UART.
+ */
+static uint8_t rxBuffer[BT_RX_BUFFER_SIZE];
+
+/**
+ * @brief Index of the next free slot of the receive ring buffer. Only written by the receive ISR.
+ */
+static volatile uint8_t rxHead = 0;
+
+/**
+ * @brief Index of the next byte to read from the receive ring buffer. Only written by the main loop.
+ */
+static volatile uint8_t rxTail = 0;
+
+#ifdef PROFILE_TIMING
+/**
+ * @brief Reception time of each byte of the receive ring buffer (µs).
+ */
+static unsigned long rxTimes[BT_RX_BUFFER_SIZE];
+
+/**
+ * @brief Reception time of the last byte read (µs).
+ */
+static unsigned long rxLastReadTime = 0;
+#endif
+
+/**
+ * @brief Number of received bytes dropped because the ring buffer was full.
+ */
+static volatile uint16_t rxOverflows = 0;
+
+/**
+ * @brief Number of data overruns flagged by the UART: received bytes lost because the receive interrupt was held off too long.
+ */
+static volatile uint16_t rxOverruns = 0;
+
+//=============================================================================
+//                              CLASS DEFINITIONS
+//=============================================================================
+
+/**
+ * @brief Configures the UART and enables its receive interrupt.
+ * @param baud Rate the Bluetooth module communicates at.
+ */
+void BluetoothUart::begin(unsigned long baud) {
+    rxHead = 0;
+    rxTail = 0;
+    rxOverflows = 0;
+    rxOverruns = 0;
+
+    // Double speed mode, rounded baud rate register value
+    BT_UCSRA = _BV(U2X1);
+    BT_UBRR = (F_CPU / 4 / baud - 1) / 2;
+
+    // 8 data bits, no parity, 1 stop bit
+    BT_UCSRC = _BV(UCSZ11) | _BV(UCSZ10);
+    BT_UCSRB = _BV(RXEN1) | _BV(TXEN1) | _BV(RXCIE1);
+}
+
+/**
+ * @brief Gets the number of received bytes waiting in the ring buffer.
+ * @return Number of bytes that can be read.
+ */
+int BluetoothUart::available() {
+    return (uint8_t)(rxHead - rxTail) & (BT_RX_BUFFER_SIZE - 1);
+}
+
+/**
+ * @brief Reads the next received byte.
+ * @return The byte, or -1 if the ring buffer is empty.
+ */
+int BluetoothUart::read() {
+    uint8_t tail = rxTail;
+
+    if (tail == rxHead) {
+        return -1;
+    }
+
+    uint8_t byte = rxBuffer[tail];
+
+    #ifdef PROFILE_TIMING
+    rxLastReadTime = rxTimes[tail];
+    #endif
+
+    rxTail = (tail + 1) & (BT_RX_BUFFER_SIZE - 1);
+    return byte;
+}
+
+/**
+ * @brief Gets the next received byte without removing it from the ring buffer.
+ * @return The byte, or -1 if the ring buffer is empty.
+ */
+int BluetoothUart::peek() {
+    uint8_t tail = rxTail;
+
+    if (tail == rxHead) {
+        return -1;
+    }
+
+    return rxBuffer[tail];
+}
+
+/**
+ * @brief Sends a byte, waiting for the UART to be ready.
+ * @param byte The byte to send.
+ * @return Number of bytes sent.
+ */
+size_t BluetoothUart::write(uint8_t byte) {
+    while (!(BT_UCSRA & _BV(UDRE1)));
+    BT_UDR = byte;
+    return 1;
+}
+
+/**
+ * @brief Gets the number of received bytes dropped because the ring buffer was full.
+ * @return Number of dropped bytes since begin().
+ */
+uint16_t BluetoothUart::overflows() {
+    uint16_t count;
+
+    // 16-bit value also written by the ISR
+    uint8_t oldSREG = SREG;
+    cli();
+    count = rxOverflows;
+    SREG = oldSREG;
+
+    return count;
+}
+
+/**
+ * @brief Gets the number of received bytes lost by the UART because the receive interrupt was held off, e.g. while the LED strip is sent.
+ * @return Number of data overruns since begin(). Several bytes may have been lost at each overrun.
+ */
+uint16_t BluetoothUart::overruns() {
+    uint16_t count;
+
+    // 16-bit value also written by the ISR
+    uint8_t oldSREG = SREG;
+    cli();
+    count = rxOverruns;
+    SREG = oldSREG;
+
+    return count;
+}
+
+#ifdef PROFILE_TIMING
+/**
+ * @brief Gets the reception time of the last byte read.
+ * @return Time the receive interrupt stored the byte (µs).
+ */
+unsigned long BluetoothUart::readTime() {
+    return rxLastReadTime;
+}
+#endif
+
+/**
+ * @brief Bluetooth UART receive interrupt: stores the received byte in the ring buffer.
+ */
+ISR(BT_RX_vect) {
+    // The overrun flag is only valid before the data register is read
+    if (BT_UCSRA & _BV(DOR1)) {
+        rxOverruns++;
+    }
+
+    // Reading the data register clears the interrupt flag, even if the byte is dropped
+    uint8_t byte = BT_UDR;
+    uint8_t head = rxHead;
+    uint8_t next = (head + 1) & (BT_RX_BUFFER_SIZE - 1);
+
+    // One slot is kept empty to distinguish a full buffer from an empty one
+    if (next == rxTail) {
+        rxOverflows++;
+        return;
+    }
+
+    rxBuffer[head] = byte;
+
+    #ifdef PROFILE_TIMING
+    rxTimes[head] = micros();
+    #endif
+
+    rxHead = next;
+}
 
 //=============================================================================
 //                              ROUTINE DEFINITIONS
 //=============================================================================
 
 
+/**
+ * @brief Updates the link statistics when a valid command is decoded.
+ */
+static void recordValidFrame() {
+    unsigned long now = micros();
+
+    if (btLinkStats.linkActive) {
+        unsigned long interval = now - btLinkStats.lastFrameMicros;
+        long variation = (interval > btLinkStats.lastInterval) ? interval - btLinkStats.lastInterval : btLinkStats.lastInterval - interval;
+
+        btLinkStats.jitter += (variation - (long)btLinkStats.jitter) / 16;
+        btLinkStats.lastInterval = interval;
+
+        if (interval > btLinkStats.maxInterval) {
+            btLinkStats.maxInterval = interval;
+        }
+    }
+
+    btLinkStats.lastFrameMicros = now;
+    btLinkStats.lastFrameTime = millis();
+    btLinkStats.linkActive = true;
+
+    if (btLinkStats.validFrames < UINT16_MAX) {
+        btLinkStats.validFrames++;
+    }
+}
+
+/**
+ * @brief Updates the malformed frame count of the link statistics.
+ */
+static void recordMalformedFrame() {
+    if (btLinkStats.malformedFrames < UINT16_MAX) {
+        btLinkStats.malformedFrames++;
+    }
+}
+
+/**
+ * @brief Counts the binary frames missing before the given sequence number.
+ * @param sequence Sequence number of the binary frame just received.
+ */
+static void recordSequence(uint8_t sequence) {
+    if (btLinkStats.sequenceValid) {
+        uint8_t missing = sequence - btLinkStats.lastSequence - 1;
+        btLinkStats.droppedFrames = (UINT16_MAX - btLinkStats.droppedFrames > missing) ? btLinkStats.droppedFrames + missing : UINT16_MAX;
+    }
+
+    btLinkStats.lastSequence = sequence;
+    btLinkStats.sequenceValid = true;
+}
+
 /**
  * @brief Processes Bluetooth data and updates the scaled X and Y coordinates accordingly.
  *
@@ -31,112 +308,634 @@ SoftwareSerial BlueT(RX, TX);
  * It supports various commands that can:
  *      - move the coordinates to predefined positions : case where data is sent using a pad with few possible values.
  *      - allow parsing of custom coordinate values : case where data is sent from a joystick via Bluetooth (from a smartphone or not).
+ *      - decode the binary frames sent by the TI remote, starting with BT_SYNC.
+ *
+ * The function never blocks: it only consumes the bytes already received. A joystick frame can be split over several calls,
+ * its bytes are stored in a fixed buffer until the '_' suffix is received. Truncated, too long or malformed frames are dropped.
+ * Binary frames with a wrong CRC are dropped, the parser then resynchronises on the next BT_SYNC byte.
+ * Once a valid binary frame is received, the legacy ASCII and pad commands are ignored until the link times out.
  *
  * @param scaled_X Pointer to an integer that will hold the updated scaled X coordinate.
  * @param scaled_Y Pointer to an integer that will hold the updated scaled Y coordinate.
- * @return True if the motors should be updated, false otherwise (case where just the mode is updated).
+ * @return True if the motors should be updated, false otherwise (case where just the mode is updated or no complete command was received).
  */
 bool BT_process(int* scaled_X, int* scaled_Y) {
-    
-    char BT_Data = BlueT.read();
-    
-    bool shouldUpdateMotors = true;
-    
-    switch (BT_Data){
-        // First cases : received data from a pad with few possible values.
-        case 'A':
-            *scaled_X = DEFAULT_POSITION; 
-            *scaled_Y = 0;
-            break;
-
-        case 'B':
-            *scaled_X = DEFAULT_POSITION; 
-            *scaled_Y = DEFAULT_POSITION;
-            break;
-
-        case 'C':
-            *scaled_X = 0; 
-            *scaled_Y = DEFAULT_POSITION;
-            break;
-
-        case 'D':
-            *scaled_X = -DEFAULT_POSITION; 
-            *scaled_Y = DEFAULT_POSITION;
-            break;
-
-        case 'E':
-            *scaled_X = -DEFAULT_POSITION;
-            *scaled_Y = 0;
-            break;
-
-        case 'F':
-            *scaled_X = -DEFAULT_POSITION; 
-            *scaled_Y = -DEFAULT_POSITION;
-            break;
-
-        case 'G':
-            *scaled_X = 0; 
-            *scaled_Y = -DEFAULT_POSITION;
-            break;
-
-        case 'H':
-            *scaled_X = DEFAULT_POSITION; 
-            *scaled_Y = -DEFAULT_POSITION;
-            break;
-
-        // 'S' stands for stop
-        case 'S':
-            *scaled_X = 0; 
-            *scaled_Y = 0;
-            shouldUpdateMotors = false;
-            break;
-
-        // 'M' stands for mode
-        case 'M':
-            updateMode();
-            shouldUpdateMotors = false;
-            break;
-
-        // '*' is the prefix for Bluetooth data received from a joystick (not a pad)
-        case '*':
-            #ifdef DEBUG_MOTORS
-            debug.printf("* spotted as prefix in BT_process\n");
-            #endif
 
+    // Joystick frame being received, kept between calls.
+    static char frameBuffer[BT_FRAME_SIZE];
+    static uint8_t frameLength = 0;
+    static bool inFrame = false;
+
+    // Binary frame being received, kept between calls.
+    static uint8_t binaryFrame[BT_BINARY_FRAME_SIZE];
+    static uint8_t binaryLength = 0;
+
+    int pending = BlueT.available();
+
+    while (pending-- > 0) {
+
+        char BT_Data = BlueT.read();
+
+        if (binaryLength > 0) {
+            binaryFrame[binaryLength++] = BT_Data;
+
+            if (binaryLength < BT_BINARY_FRAME_SIZE) {
+                continue;
+            }
+
+            binaryLength = 0;
+
+            if (crc8(binaryFrame + 1, BT_BINARY_FRAME_SIZE - 2) != binaryFrame[BT_BINARY_FRAME_SIZE - 1]) {
+                #ifdef DEBUG_BT
+                logEvent(LOG_BT_WRONG_CRC, binaryFrame[4]);
+                #endif
+
+                recordMalformedFrame();
+
+                // A byte was probably lost: restart from the next sync byte of the frame if any
+                for (uint8_t i = 1; i < BT_BINARY_FRAME_SIZE; i++) {
+                    if (binaryFrame[i] == BT_SYNC) {
+                        binaryLength = BT_BINARY_FRAME_SIZE - i;
+                        memmove(binaryFrame, binaryFrame + i, binaryLength);
+                        break;
+                    }
+                }
+                continue;
+            }
+
+            recordValidFrame();
+            recordSequence(binaryFrame[4]);
+            btLinkStats.binaryLink = true;
+
+            switch (binaryFrame[1]) {
+                case BT_MSG_JOYSTICK:
+                    *scaled_X = 4 * binaryFrame[2] - DEFAULT_POSITION;
+                    *scaled_Y = 4 * binaryFrame[3] - DEFAULT_POSITION;
+                    return true;
+
+                case BT_MSG_MODE:
+                    updateMode();
+                    return false;
+
+                // Unknown message types are ignored
+                default:
+                    continue;
+            }
+        }
+
+        // The sync byte starts a binary frame and ends any truncated ASCII frame
+        if ((uint8_t)BT_Data == BT_SYNC) {
+            if (inFrame) {
+                inFrame = false;
+                recordMalformedFrame();
+            }
+            binaryFrame[0] = BT_SYNC;
+            binaryLength = 1;
+            continue;
+        }
+
+        if (inFrame) {
             // '_' is the suffix for Bluetooth data received from a joystick (not a pad)
-            String lineData = BlueT.readStringUntil('_');
-            Serial.println("Received data : " + lineData);
-            
-            // Parse received values and then scale it.
-            // First multiply by 4 to scale data that are chars and must be converted to int and then shifted to range in [- DEFAULT_POSITION; DEFAULT_POSITION]
-            *scaled_X = 4 * parseValue(lineData, 'X') - DEFAULT_POSITION; 
-            *scaled_Y = 4 * parseValue(lineData, 'Y') - DEFAULT_POSITION; 
-        
-            break;
+            if (BT_Data == '_') {
+                inFrame = false;
+                frameBuffer[frameLength] = '\0';
+
+                int X = parseValue(frameBuffer, 'X');
+                int Y = parseValue(frameBuffer, 'Y');
+
+                #ifdef DEBUG_BT
+                logEvent(LOG_BT_FRAME, X, Y);
+                #endif
+
+                if (X < 0 || Y < 0) {
+                    recordMalformedFrame();
+                    continue;
+                }
+
+                recordValidFrame();
+
+                // Parsed values range in [0; 255], so first multiply by 4 and then shift them to range in [- DEFAULT_POSITION; DEFAULT_POSITION]
+                *scaled_X = 4 * X - DEFAULT_POSITION;
+                *scaled_Y = 4 * Y - DEFAULT_POSITION;
+                return true;
+            }
+
+            if (isDigit(BT_Data) || BT_Data == 'X' || BT_Data == 'Y' || BT_Data == ',') {
+                if (frameLength < BT_FRAME_SIZE - 1) {
+                    frameBuffer[frameLength++] = BT_Data;
+                } else {
+                    // Frame too long: drop it
+                    inFrame = false;
+                    recordMalformedFrame();
+                }
+                continue;
+            }
+
+            // Any other character ends the truncated frame and is handled as a new command
+            inFrame = false;
+            recordMalformedFrame();
+        }
+
+        bool legacyCommand = (BT_Data >= 'A' && BT_Data <= 'H') || BT_Data == 'S' || BT_Data == 'M' || BT_Data == '*';
+
+        // On a binary link, a legacy command can only be a payload byte read after a lost sync byte: it must not move the robot
+        if (btLinkStats.binaryLink) {
+            if (legacyCommand) {
+                recordMalformedFrame();
+            }
+            continue;
+        }
+
+        // Pad commands
+        if (legacyCommand && BT_Data != '*') {
+            recordValidFrame();
+        }
+
+        switch (BT_Data){
+            // First cases : received data from a pad with few possible values.
+            case 'A':
+                *scaled_X = DEFAULT_POSITION;
+                *scaled_Y = 0;
+                return true;
+
+            case 'B':
+                *scaled_X = DEFAULT_POSITION;
+                *scaled_Y = DEFAULT_POSITION;
+                return true;
+
+            case 'C':
+                *scaled_X = 0;
+                *scaled_Y = DEFAULT_POSITION;
+                return true;
+
+            case 'D':
+                *scaled_X = -DEFAULT_POSITION;
+                *scaled_Y = DEFAULT_POSITION;
+                return true;
+
+            case 'E':
+                *scaled_X = -DEFAULT_POSITION;
+                *scaled_Y = 0;
+                return true;
+
+            case 'F':
+                *scaled_X = -DEFAULT_POSITION;
+                *scaled_Y = -DEFAULT_POSITION;
+                return true;
+
+            case 'G':
+                *scaled_X = 0;
+                *scaled_Y = -DEFAULT_POSITION;
+                return true;
+
+            case 'H':
+                *scaled_X = DEFAULT_POSITION;
+                *scaled_Y = -DEFAULT_POSITION;
+                return true;
+
+            // 'S' stands for stop
+            case 'S':
+                *scaled_X = 0;
+                *scaled_Y = 0;
+                return false;
+
+            // 'M' stands for mode
+            case 'M':
+                updateMode();
+                return false;
+
+            // '*' is the prefix for Bluetooth data received from a joystick (not a pad)
+            case '*':
+                #ifdef DEBUG_MOTORS
+                logEvent(LOG_BT_PREFIX);
+                #endif
+
+                inFrame = true;
+                frameLength = 0;
+                break;
+
+            // Garbage between commands is ignored
+            default:
+                break;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Checks whether the link has been silent for BT_COMMAND_TIMEOUT since the last valid command.
+ * @return True once when the timeout expires, then false until a new valid command is received.
+ */
+bool BT_checkTimeout() {
+    if (!btLinkStats.linkActive || millis() - btLinkStats.lastFrameTime < BT_COMMAND_TIMEOUT) {
+        return false;
+    }
+
+    // The next frame starts a new link: its interval and sequence number are not compared to the previous ones
+    btLinkStats.linkActive = false;
+    btLinkStats.sequenceValid = false;
+    btLinkStats.binaryLink = false;
+
+    if (btLinkStats.timeouts < UINT16_MAX) {
+        btLinkStats.timeouts++;
     }
-    return shouldUpdateMotors;
+
+    return true;
+}
+
+/**
+ * @brief Prints the Bluetooth link statistics on the serial port.
+ */
+void BT_printStats() {
+    Serial.print("BT link: ");
+    Serial.print(btLinkStats.linkActive ? "active" : "lost");
+    Serial.print(", last command ");
+    Serial.print(millis() - btLinkStats.lastFrameTime);
+    Serial.print(" ms ago, valid ");
+    Serial.print(btLinkStats.validFrames);
+    Serial.print(", malformed ");
+    Serial.print(btLinkStats.malformedFrames);
+    Serial.print(", dropped ");
+    Serial.print(btLinkStats.droppedFrames);
+    Serial.print(", UART overflows ");
+    Serial.print(BlueT.overflows());
+    Serial.print(", UART overruns ");
+    Serial.print(BlueT.overruns());
+    Serial.print(", timeouts ");
+    Serial.println(btLinkStats.timeouts);
+
+    Serial.print("BT intervals: last ");
+    Serial.print(btLinkStats.lastInterval);
+    Serial.print(" us, max ");
+    Serial.print(btLinkStats.maxInterval);
+    Serial.print(" us, jitter ");
+    Serial.print(btLinkStats.jitter);
+    Serial.println(" us");
 }
 
 /**
  * @brief Parses a value from a string of data.
  *
- * @param data The string of data to parse. Its format is expected to be "X<value_X>,Y<value_Y>"
+ * @param data The null-terminated string of data to parse. Its format is expected to be "X<value_X>,Y<value_Y>"
  * @param axis The character representing the axis to parse ('X' or 'Y').
- * @return The parsed value, or 0 if the axis is not found.
+ * @return The parsed value in [0; 255], or -1 if the axis is not found or its value is missing or out of range.
  */
-int parseValue(String data, char axis) {
-    int index = data.indexOf(axis);
-    if (index == -1) return 0;
-    
+int parseValue(const char* data, char axis) {
+    const char* position = strchr(data, axis);
+    if (position == NULL) return -1;
+
     // Start right after the axis character
-    int startIndex = index + 1;
+    position++;
 
-    // Find next letter or end of string
-    int endIndex = startIndex;
-    while (endIndex < data.length() && isDigit(data.charAt(endIndex))) {
-        endIndex++;
+    // Read digits until the next letter or the end of string
+    int value = 0;
+    uint8_t digits = 0;
+    while (isDigit(*position)) {
+        value = 10 * value + (*position - '0');
+        position++;
+
+        if (++digits > 3) return -1;
     }
-    
-    String valueStr = data.substring(startIndex, endIndex);
-    return valueStr.toInt();
-}
\ No newline at end of file
+
+    if (digits == 0 || value > 255) return -1;
+
+    return value;
+}
+
+/**
+ * @brief Computes the CRC-8 of a binary frame.
+ * @param data Bytes to compute the CRC of.
+ * @param length Number of bytes.
+ * @return The CRC-8 (polynomial BT_CRC8_POLYNOMIAL, initial value 0).
+ */
+uint8_t crc8(const uint8_t* data, uint8_t length) {
+    uint8_t crc = 0;
+
+    while (length--) {
+        crc ^= *data++;
+
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (crc << 1) ^ BT_CRC8_POLYNOMIAL : crc << 1;
+        }
+    }
+
+    return crc;
+}
+
+#ifdef BENCHMARK_BT
+
+/**
+ * @brief Results of one scenario of the decoder benchmark.
+ */
+typedef struct btBenchResult_t {
+    unsigned long bytes;        /**< Number of bytes fed */
+    unsigned long cycles;       /**< CPU cycles spent in BT_process() */
+    uint16_t frames;            /**< Number of commands decoded */
+    uint16_t expectedFrames;    /**< Number of legal commands fed, 0 if unknown */
+    uint16_t outOfRange;        /**< Number of decoded values outside [- DEFAULT_POSITION; DEFAULT_POSITION] */
+    uint16_t hangs;             /**< Number of calls that did not consume any byte */
+} btBenchResult_t;
+
+/**
+ * @brief Largest chunk fed at once, must fit in the receive ring buffer.
+ */
+#define BENCHMARK_BT_CHUNK_SIZE (BT_RX_BUFFER_SIZE - 28)
+
+/**
+ * @brief Number of chunks fed per scenario.
+ */
+#define BENCHMARK_BT_CHUNKS 200
+
+/**
+ * @brief State of the pseudo-random generator of the benchmark, fixed so that the runs are reproducible.
+ */
+static uint16_t benchSeed = 0xACE1;
+
+/**
+ * @brief Gets a pseudo-random byte (16-bit xorshift).
+ */
+static uint8_t benchRandom() {
+    benchSeed ^= benchSeed << 7;
+    benchSeed ^= benchSeed >> 9;
+    benchSeed ^= benchSeed << 8;
+    return benchSeed;
+}
+
+/**
+ * @brief Gets the memory allocated on the heap.
+ * @details On the board, the top of the heap. In the host simulation, the memory allocated by malloc() and not freed.
+ */
+static size_t benchHeapSize() {
+#ifdef HOST_SIMULATION
+    return hostHeapUsed();
+#else
+    extern char __heap_start;
+    extern char* __brkval;
+    return (__brkval != NULL ? __brkval : &__heap_start) - &__heap_start;
+#endif
+}
+
+/**
+ * @brief Appends a legal ASCII joystick frame with random values.
+ * @return Number of bytes appended.
+ */
+static uint8_t benchAsciiFrame(uint8_t* data) {
+    return snprintf((char*)data, BT_FRAME_SIZE + 2, "*X%u,Y%u_", benchRandom(), benchRandom());
+}
+
+/**
+ * @brief Appends a legal binary joystick frame with random values.
+ * @return Number of bytes appended.
+ */
+static uint8_t benchBinaryFrame(uint8_t* data) {
+    static uint8_t sequence = 0;
+
+    data[0] = BT_SYNC;
+    data[1] = BT_MSG_JOYSTICK;
+    data[2] = benchRandom();
+    data[3] = benchRandom();
+    data[4] = sequence++;
+    data[5] = crc8(data + 1, BT_BINARY_FRAME_SIZE - 2);
+    return BT_BINARY_FRAME_SIZE;
+}
+
+/**
+ * @brief Appends a random direction pad command, 'A' to 'H'.
+ * @return Number of bytes appended.
+ */
+static uint8_t benchPadCommand(uint8_t* data) {
+    data[0] = 'A' + (benchRandom() & 7);
+    return 1;
+}
+
+/**
+ * @brief Feeds a chunk to the receive ring buffer and decodes it, updating the results.
+ * @details On the board, the bytes are written to the ring buffer, as by the receive ISR. In the host simulation, they are
+ *          sent to the simulated USART1 and received by its ISR, the whole chunk before it is decoded.
+ * @param data Bytes to feed, BENCHMARK_BT_CHUNK_SIZE at most.
+ * @param length Number of bytes.
+ * @param result Results to update.
+ */
+static void benchDecode(const uint8_t* data, uint8_t length, btBenchResult_t* result) {
+#ifdef HOST_SIMULATION
+    int pending = BlueT.available();
+
+    // Transmission time of the chunk, then of the last byte to the ring buffer. A byte lost to a data overrun, when the
+    // firmware runs too slowly (see hostSetCpuScale()), is not counted and its frame is missing from the results.
+    hostBluetoothReceive(data, length);
+    delay(10000UL * length / BT_RATE + 2);
+
+    result->bytes += BlueT.available() - pending;
+#else
+    for (uint8_t i = 0; i < length; i++) {
+        rxBuffer[rxHead] = data[i];
+        rxHead = (rxHead + 1) & (BT_RX_BUFFER_SIZE - 1);
+    }
+
+    result->bytes += length;
+#endif
+
+    while (BlueT.available()) {
+        int pending = BlueT.available();
+
+        // Out of range values, so that a command returned without values is detected
+        int X = INT16_MIN;
+        int Y = INT16_MIN;
+
+        uint32_t start = readCycleCounter();
+        bool update = BT_process(&X, &Y);
+        result->cycles += readCycleCounter() - start;
+
+        if (update) {
+            result->frames++;
+
+            if (X < -DEFAULT_POSITION || X > DEFAULT_POSITION || Y < -DEFAULT_POSITION || Y > DEFAULT_POSITION) {
+                result->outOfRange++;
+            }
+        }
+
+        if (BlueT.available() >= pending) {
+            result->hangs++;
+            rxTail = rxHead;
+        }
+    }
+}
+
+/**
+ * @brief Prints the results of a scenario.
+ * @param name Name of the scenario.
+ * @param result Results to print.
+ * @return True if the scenario passed its checks.
+ */
+static bool benchReport(const char* name, const btBenchResult_t* result) {
+    // 64-bit intermediate values, so that the rates keep the cycle resolution without overflowing
+    unsigned long cycles = (result->cycles != 0) ? result->cycles : 1;
+    unsigned long byteRate = (uint64_t)result->bytes * F_CPU / cycles;
+    unsigned long frameRate = (uint64_t)result->frames * F_CPU / cycles;
+
+    // Only the legal streams are long enough for the throughput to be meaningful
+    bool fastEnough = result->expectedFrames == 0 || byteRate >= BENCHMARK_BT_MIN_RATE;
+    bool passed = result->outOfRange == 0 && result->hangs == 0 && fastEnough
+                  && (result->expectedFrames == 0 || result->frames == result->expectedFrames);
+
+    Serial.print(name);
+    Serial.print(": ");
+    Serial.print(result->bytes);
+    Serial.print(" bytes, ");
+    Serial.print(byteRate);
+    Serial.print(" bytes/s, ");
+    if (!fastEnough) {
+        Serial.print("below ");
+        Serial.print((unsigned long)BENCHMARK_BT_MIN_RATE);
+        Serial.print(", ");
+    }
+    Serial.print(frameRate);
+    Serial.print(" frames/s, decoded ");
+    Serial.print(result->frames);
+    if (result->expectedFrames != 0) {
+        Serial.print("/");
+        Serial.print(result->expectedFrames);
+    }
+    Serial.print(", out of range ");
+    Serial.print(result->outOfRange);
+    Serial.print(", hangs ");
+    Serial.print(result->hangs);
+    Serial.println(passed ? " PASS" : " FAIL");
+
+    return passed;
+}
+
+/**
+ * @brief Feeds generated, mutated and random streams to BT_process() and prints its throughput and robustness checks.
+ * @details Checks that every call makes progress, that the decoded values stay within [- DEFAULT_POSITION; DEFAULT_POSITION],
+ *          that the legal frames are all decoded and that no memory is allocated. Must be called before BlueT.begin().
+ */
+void benchmarkBT_process() {
+    // Edge cases: too large and missing values, missing suffix, interleaved mode and stop commands, lost binary byte
+    static const char* const edgeCases[] = {
+        "*X999999,Y_", "*X,Y_", "*X12", "8,Y0_", "*X1,YM2_", "*X10,Y10*X5,Y6_", "**__", "*X255,Y255,X1_", "_S_M",
+        "\xA5\x01\x10\x20\x00", "\xA5\xA5\xA5\xA5\xA5\xA5\xA5"
+    };
+
+    uint8_t chunk[BENCHMARK_BT_CHUNK_SIZE];
+    int savedMode = mode;
+    size_t heapSize = benchHeapSize();
+    bool passed = true;
+
+#ifdef HOST_SIMULATION
+    BlueT.begin(BT_RATE);
+#else
+    rxHead = 0;
+    rxTail = 0;
+#endif
+
+    startCycleCounter();
+
+    // Legal streams of each kind, for the throughput
+    uint8_t (*generators[3])(uint8_t*) = { benchAsciiFrame, benchBinaryFrame, benchPadCommand };
+    const char* const names[3] = { "ASCII frames", "binary frames", "pad commands" };
+
+    for (uint8_t kind = 0; kind < 3; kind++) {
+        btBenchResult_t result = { 0, 0, 0, 0, 0, 0 };
+
+        // Each legal stream starts a new link, as after a timeout, so that the pad commands are accepted after the binary frames
+        btLinkStats.binaryLink = false;
+
+        for (uint16_t n = 0; n < BENCHMARK_BT_CHUNKS; n++) {
+            uint8_t length = 0;
+
+            while (length <= BENCHMARK_BT_CHUNK_SIZE - (BT_FRAME_SIZE + 2)) {
+                length += generators[kind](chunk + length);
+                result.expectedFrames++;
+            }
+
+            benchDecode(chunk, length, &result);
+        }
+
+        passed &= benchReport(names[kind], &result);
+    }
+
+    // Mixed legal stream with random mutations: replaced, dropped and inserted bytes
+    btBenchResult_t mutated = { 0, 0, 0, 0, 0, 0 };
+    btLinkStats.binaryLink = false;
+
+    for (uint16_t n = 0; n < BENCHMARK_BT_CHUNKS; n++) {
+        uint8_t length = 0;
+
+        while (length <= BENCHMARK_BT_CHUNK_SIZE - (BT_FRAME_SIZE + 2)) {
+            length += generators[benchRandom() % 3](chunk + length);
+        }
+
+        for (uint8_t mutation = benchRandom() % 4; mutation > 0; mutation--) {
+            uint8_t position = benchRandom() % length;
+
+            switch (benchRandom() % 3) {
+                case 0:
+                    chunk[position] = benchRandom();
+                    break;
+
+                case 1:
+                    memmove(chunk + position, chunk + position + 1, length - position - 1);
+                    length--;
+                    break;
+
+                default:
+                    if (length < BENCHMARK_BT_CHUNK_SIZE) {
+                        memmove(chunk + position + 1, chunk + position, length - position);
+                        chunk[position] = (benchRandom() & 1) ? 'M' : benchRandom();
+                        length++;
+                    }
+                    break;
+            }
+        }
+
+        benchDecode(chunk, length, &mutated);
+    }
+
+    passed &= benchReport("mutated frames", &mutated);
+
+    // Random bytes
+    btBenchResult_t random = { 0, 0, 0, 0, 0, 0 };
+    btLinkStats.binaryLink = false;
+
+    for (uint16_t n = 0; n < BENCHMARK_BT_CHUNKS; n++) {
+        for (uint8_t i = 0; i < BENCHMARK_BT_CHUNK_SIZE; i++) {
+            chunk[i] = benchRandom();
+        }
+
+        benchDecode(chunk, BENCHMARK_BT_CHUNK_SIZE, &random);
+    }
+
+    passed &= benchReport("random bytes", &random);
+
+    btBenchResult_t edges = { 0, 0, 0, 0, 0, 0 };
+    btLinkStats.binaryLink = false;
+
+    for (uint8_t i = 0; i < sizeof(edgeCases) / sizeof(edgeCases[0]); i++) {
+        benchDecode((const uint8_t*)edgeCases[i], strlen(edgeCases[i]), &edges);
+    }
+
+    passed &= benchReport("edge cases", &edges);
+
+    // Leave the decoder idle: complete any pending binary frame, even resynchronised on its own sync bytes, then end any pending ASCII frame
+    btBenchResult_t flushed = { 0, 0, 0, 0, 0, 0 };
+    memset(chunk, 0, 2 * BT_BINARY_FRAME_SIZE);
+    chunk[2 * BT_BINARY_FRAME_SIZE] = 'Z';
+    benchDecode(chunk, 2 * BT_BINARY_FRAME_SIZE + 1, &flushed);
+
+    int leaked = benchHeapSize() - heapSize;
+
+    Serial.print("Memory allocated by the decoder: ");
+    Serial.print(leaked);
+    Serial.println(" bytes");
+
+    passed &= (leaked == 0);
+
+    Serial.println(passed ? "BT decoder benchmark PASS" : "BT decoder benchmark FAIL");
+
+    mode = savedMode;
+    memset(&btLinkStats, 0, sizeof(btLinkStats));
+}
+
+#endif
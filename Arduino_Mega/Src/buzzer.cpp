@@ -10,64 +10,41 @@
 
 #include "../Inc/buzzer.h"
 
+#include "../Inc/logger.h"
+
 //=============================================================================
 //                             VARIABLE DEFINITIONS
 //=============================================================================
 
 /**
  * @brief Current note being played by the buzzer.
- * @details Stores the frequency value of the currently playing musical note.
+ * @details Stores the index of the next note of the current track to queue to the tone engine.
  */
 int note = 0;
 
 /**
- * @brief Melody array for Pink Panther theme.
- * @details Contains frequency values for each note in the Pink Panther theme song.
- */
-const int melody_PinkPanther[] = {
-    REST, REST, REST, NOTE_DS4, 
-    NOTE_E4, REST, NOTE_FS4, NOTE_G4, REST, NOTE_DS4,
-    NOTE_E4, NOTE_FS4,  NOTE_G4, NOTE_C5, NOTE_B4, NOTE_E4, NOTE_G4, NOTE_B4,   
-    NOTE_AS4, NOTE_A4, NOTE_G4, NOTE_E4, NOTE_D4, 
-    NOTE_E4, REST, REST, NOTE_DS4,
-    
-    NOTE_E4, REST, NOTE_FS4, NOTE_G4, REST, NOTE_DS4,
-    NOTE_E4, NOTE_FS4,  NOTE_G4, NOTE_C5, NOTE_B4, NOTE_G4, NOTE_B4, NOTE_E5,
-    NOTE_DS5,   
-    NOTE_D5, REST, REST, NOTE_DS4, 
-    NOTE_E4, REST, NOTE_FS4, NOTE_G4, REST, NOTE_DS4,
-    NOTE_E4, NOTE_FS4,  NOTE_G4, NOTE_C5, NOTE_B4, NOTE_E4, NOTE_G4, NOTE_B4,   
-    
-    NOTE_AS4, NOTE_A4, NOTE_G4, NOTE_E4, NOTE_D4, 
-    NOTE_E4, REST,
-    REST, NOTE_E5, NOTE_D5, NOTE_B4, NOTE_A4, NOTE_G4, NOTE_E4,
-    NOTE_AS4, NOTE_A4, NOTE_AS4, NOTE_A4, NOTE_AS4, NOTE_A4, NOTE_AS4, NOTE_A4,   
-    NOTE_G4, NOTE_E4, NOTE_D4, NOTE_E4, NOTE_E4, NOTE_E4
-};
-
-/**
- * @brief Duration array for Pink Panther theme.
- * @details Contains duration values corresponding to each note in melody_PinkPanther.
+ * @brief Notes of the Pink Panther theme, stored in flash.
+ * @details Each note is a pitch index in pitch_tab and a duration code.
  */
-const int durations_PinkPanther[] = {
-    2, 4, 8, 8, 
-    4, 8, 8, 4, 8, 8,
-    8, 8,  8, 8, 8, 8, 8, 8,   
-    2, 16, 16, 16, 16, 
-    2, 4, 8, 4,
-    
-    4, 8, 8, 4, 8, 8,
-    8, 8,  8, 8, 8, 8, 8, 8,
-    1,   
-    2, 4, 8, 8, 
-    4, 8, 8, 4, 8, 8,
-    8, 8,  8, 8, 8, 8, 8, 8,   
-    
-    2, 16, 16, 16, 16, 
-    4, 4,
-    4, 8, 8, 8, 8, 8, 8,
-    16, 8, 16, 8, 16, 8, 16, 8,   
-    16, 16, 16, 16, 16, 2
+const songNote_t song_PinkPanther[] PROGMEM = {
+    { PITCH_REST, HALF }, { PITCH_REST, QUARTER }, { PITCH_REST, EIGHTH }, { PITCH_DS4, EIGHTH },
+    { PITCH_E4, QUARTER }, { PITCH_REST, EIGHTH }, { PITCH_FS4, EIGHTH }, { PITCH_G4, QUARTER }, { PITCH_REST, EIGHTH }, { PITCH_DS4, EIGHTH },
+    { PITCH_E4, EIGHTH }, { PITCH_FS4, EIGHTH }, { PITCH_G4, EIGHTH }, { PITCH_C5, EIGHTH }, { PITCH_B4, EIGHTH }, { PITCH_E4, EIGHTH }, { PITCH_G4, EIGHTH }, { PITCH_B4, EIGHTH },
+    { PITCH_AS4, HALF }, { PITCH_A4, SIXTEENTH }, { PITCH_G4, SIXTEENTH }, { PITCH_E4, SIXTEENTH }, { PITCH_D4, SIXTEENTH },
+    { PITCH_E4, HALF }, { PITCH_REST, QUARTER }, { PITCH_REST, EIGHTH }, { PITCH_DS4, QUARTER },
+
+    { PITCH_E4, QUARTER }, { PITCH_REST, EIGHTH }, { PITCH_FS4, EIGHTH }, { PITCH_G4, QUARTER }, { PITCH_REST, EIGHTH }, { PITCH_DS4, EIGHTH },
+    { PITCH_E4, EIGHTH }, { PITCH_FS4, EIGHTH }, { PITCH_G4, EIGHTH }, { PITCH_C5, EIGHTH }, { PITCH_B4, EIGHTH }, { PITCH_G4, EIGHTH }, { PITCH_B4, EIGHTH }, { PITCH_E5, EIGHTH },
+    { PITCH_DS5, WHOLE },
+    { PITCH_D5, HALF }, { PITCH_REST, QUARTER }, { PITCH_REST, EIGHTH }, { PITCH_DS4, EIGHTH },
+    { PITCH_E4, QUARTER }, { PITCH_REST, EIGHTH }, { PITCH_FS4, EIGHTH }, { PITCH_G4, QUARTER }, { PITCH_REST, EIGHTH }, { PITCH_DS4, EIGHTH },
+    { PITCH_E4, EIGHTH }, { PITCH_FS4, EIGHTH }, { PITCH_G4, EIGHTH }, { PITCH_C5, EIGHTH }, { PITCH_B4, EIGHTH }, { PITCH_E4, EIGHTH }, { PITCH_G4, EIGHTH }, { PITCH_B4, EIGHTH },
+
+    { PITCH_AS4, HALF }, { PITCH_A4, SIXTEENTH }, { PITCH_G4, SIXTEENTH }, { PITCH_E4, SIXTEENTH }, { PITCH_D4, SIXTEENTH },
+    { PITCH_E4, QUARTER }, { PITCH_REST, QUARTER },
+    { PITCH_REST, QUARTER }, { PITCH_E5, EIGHTH }, { PITCH_D5, EIGHTH }, { PITCH_B4, EIGHTH }, { PITCH_A4, EIGHTH }, { PITCH_G4, EIGHTH }, { PITCH_E4, EIGHTH },
+    { PITCH_AS4, SIXTEENTH }, { PITCH_A4, EIGHTH }, { PITCH_AS4, SIXTEENTH }, { PITCH_A4, EIGHTH }, { PITCH_AS4, SIXTEENTH }, { PITCH_A4, EIGHTH }, { PITCH_AS4, SIXTEENTH }, { PITCH_A4, EIGHTH },
+    { PITCH_G4, SIXTEENTH }, { PITCH_E4, SIXTEENTH }, { PITCH_D4, SIXTEENTH }, { PITCH_E4, SIXTEENTH }, { PITCH_E4, SIXTEENTH }, { PITCH_E4, HALF }
 };
 
 //------------------------------------------------------------------------------
@@ -75,25 +52,14 @@ const int durations_PinkPanther[] = {
 //------------------------------------------------------------------------------
 
 /**
- * @brief Melody array for Nokia ringtone.
- * @details Contains frequency values for each note in the Nokia ringtone.
- */
-const int melody_Nokia[] = {
-    NOTE_E5, NOTE_D5, NOTE_FS4, NOTE_GS4, 
-    NOTE_CS5, NOTE_B4, NOTE_D4, NOTE_E4, 
-    NOTE_B4, NOTE_A4, NOTE_CS4, NOTE_E4,
-    NOTE_A4
-};
-
-/**
- * @brief Duration array for Nokia ringtone.
- * @details Contains duration values corresponding to each note in melody_Nokia.
+ * @brief Notes of the Nokia ringtone, stored in flash.
+ * @details Each note is a pitch index in pitch_tab and a duration code.
  */
-const int durations_Nokia[] = {
-    8, 8, 4, 4,
-    8, 8, 4, 4,
-    8, 8, 4, 4,
-    2
+const songNote_t song_Nokia[] PROGMEM = {
+    { PITCH_E5, EIGHTH }, { PITCH_D5, EIGHTH }, { PITCH_FS4, QUARTER }, { PITCH_GS4, QUARTER },
+    { PITCH_CS5, EIGHTH }, { PITCH_B4, EIGHTH }, { PITCH_D4, QUARTER }, { PITCH_E4, QUARTER },
+    { PITCH_B4, EIGHTH }, { PITCH_A4, EIGHTH }, { PITCH_CS4, QUARTER }, { PITCH_E4, QUARTER },
+    { PITCH_A4, HALF }
 };
 
 //------------------------------------------------------------------------------
@@ -101,49 +67,26 @@ const int durations_Nokia[] = {
 //------------------------------------------------------------------------------
 
 /**
- * @brief Melody array for Subway Surfers theme.
- * @details Contains frequency values for each note in the Subway Surfers theme.
+ * @brief Notes of the Subway Surfers theme, stored in flash.
+ * @details Each note is a pitch index in pitch_tab and a duration code.
  */
-const int melody_SubwaySurfers[] = {
-    NOTE_C4, REST, NOTE_G4, REST, NOTE_AS4, NOTE_C5, NOTE_AS4, REST, NOTE_F4, NOTE_DS4, REST,
-    NOTE_C4, REST, NOTE_G4, REST, NOTE_AS4, NOTE_C5, NOTE_AS4, REST, NOTE_F4, NOTE_DS4, REST,
-    NOTE_C4, REST, NOTE_G4, REST, NOTE_AS4, NOTE_C5, NOTE_AS4, REST, NOTE_F4, NOTE_DS4, REST,
-    
-    NOTE_C4, REST, NOTE_E4, REST, NOTE_G4, NOTE_A4, NOTE_AS4,
-    NOTE_C5, REST, NOTE_C5, REST, NOTE_AS4, REST, NOTE_A4, REST,
-    NOTE_AS4, REST, NOTE_AS4, NOTE_C5, REST, NOTE_AS4, NOTE_A4, REST,
-    REST,
-    NOTE_C5, REST, NOTE_AS4, REST, NOTE_A4, REST, NOTE_AS4, REST, NOTE_E5,
-    REST,
-    
-    NOTE_C5, REST, NOTE_C5, REST, NOTE_AS4, REST, NOTE_A4, REST,
-    NOTE_AS4, REST, NOTE_AS4, NOTE_C5, REST, NOTE_AS4, NOTE_A4, REST,
-    REST,
-    NOTE_C5, REST, NOTE_AS4, REST, NOTE_A4, REST, NOTE_AS4, REST, NOTE_E4,
-    REST,
-};
-
-/**
- * @brief Duration array for Subway Surfers theme.
- * @details Contains duration values corresponding to each note in melody_SubwaySurfers.
- */
-const int durations_SubwaySurfers[] = {
-    4, 8, 4, 8, 4, 8, 8, 16, 8, 8, 16,
-    4, 8, 4, 8, 4, 8, 8, 16, 8, 8, 16,
-    4, 8, 4, 8, 4, 8, 8, 16, 8, 8, 16,
-    
-    4, 8, 4, 8, 4, 4, 4,
-    8, 16, 8, 16, 8, 16, 8, 16,
-    8, 16, 8, 8, 16, 8, 8, 16,
-    4,
-    8, 16, 8, 16, 8, 16, 8, 4, 8,
-    4,
-    
-    8, 16, 8, 16, 8, 16, 8, 16,
-    8, 16, 8, 8, 16, 8, 8, 16,
-    4,
-    8, 16, 8, 16, 8, 16, 8, 4, 8,
-    1
+const songNote_t song_SubwaySurfers[] PROGMEM = {
+    { PITCH_C4, QUARTER }, { PITCH_REST, EIGHTH }, { PITCH_G4, QUARTER }, { PITCH_REST, EIGHTH }, { PITCH_AS4, QUARTER }, { PITCH_C5, EIGHTH }, { PITCH_AS4, EIGHTH }, { PITCH_REST, SIXTEENTH }, { PITCH_F4, EIGHTH }, { PITCH_DS4, EIGHTH }, { PITCH_REST, SIXTEENTH },
+    { PITCH_C4, QUARTER }, { PITCH_REST, EIGHTH }, { PITCH_G4, QUARTER }, { PITCH_REST, EIGHTH }, { PITCH_AS4, QUARTER }, { PITCH_C5, EIGHTH }, { PITCH_AS4, EIGHTH }, { PITCH_REST, SIXTEENTH }, { PITCH_F4, EIGHTH }, { PITCH_DS4, EIGHTH }, { PITCH_REST, SIXTEENTH },
+    { PITCH_C4, QUARTER }, { PITCH_REST, EIGHTH }, { PITCH_G4, QUARTER }, { PITCH_REST, EIGHTH }, { PITCH_AS4, QUARTER }, { PITCH_C5, EIGHTH }, { PITCH_AS4, EIGHTH }, { PITCH_REST, SIXTEENTH }, { PITCH_F4, EIGHTH }, { PITCH_DS4, EIGHTH }, { PITCH_REST, SIXTEENTH },
+
+    { PITCH_C4, QUARTER }, { PITCH_REST, EIGHTH }, { PITCH_E4, QUARTER }, { PITCH_REST, EIGHTH }, { PITCH_G4, QUARTER }, { PITCH_A4, QUARTER }, { PITCH_AS4, QUARTER },
+    { PITCH_C5, EIGHTH }, { PITCH_REST, SIXTEENTH }, { PITCH_C5, EIGHTH }, { PITCH_REST, SIXTEENTH }, { PITCH_AS4, EIGHTH }, { PITCH_REST, SIXTEENTH }, { PITCH_A4, EIGHTH }, { PITCH_REST, SIXTEENTH },
+    { PITCH_AS4, EIGHTH }, { PITCH_REST, SIXTEENTH }, { PITCH_AS4, EIGHTH }, { PITCH_C5, EIGHTH }, { PITCH_REST, SIXTEENTH }, { PITCH_AS4, EIGHTH }, { PITCH_A4, EIGHTH }, { PITCH_REST, SIXTEENTH },
+    { PITCH_REST, QUARTER },
+    { PITCH_C5, EIGHTH }, { PITCH_REST, SIXTEENTH }, { PITCH_AS4, EIGHTH }, { PITCH_REST, SIXTEENTH }, { PITCH_A4, EIGHTH }, { PITCH_REST, SIXTEENTH }, { PITCH_AS4, EIGHTH }, { PITCH_REST, QUARTER }, { PITCH_E5, EIGHTH },
+    { PITCH_REST, QUARTER },
+
+    { PITCH_C5, EIGHTH }, { PITCH_REST, SIXTEENTH }, { PITCH_C5, EIGHTH }, { PITCH_REST, SIXTEENTH }, { PITCH_AS4, EIGHTH }, { PITCH_REST, SIXTEENTH }, { PITCH_A4, EIGHTH }, { PITCH_REST, SIXTEENTH },
+    { PITCH_AS4, EIGHTH }, { PITCH_REST, SIXTEENTH }, { PITCH_AS4, EIGHTH }, { PITCH_C5, EIGHTH }, { PITCH_REST, SIXTEENTH }, { PITCH_AS4, EIGHTH }, { PITCH_A4, EIGHTH }, { PITCH_REST, SIXTEENTH },
+    { PITCH_REST, QUARTER },
+    { PITCH_C5, EIGHTH }, { PITCH_REST, SIXTEENTH }, { PITCH_AS4, EIGHTH }, { PITCH_REST, SIXTEENTH }, { PITCH_A4, EIGHTH }, { PITCH_REST, SIXTEENTH }, { PITCH_AS4, EIGHTH }, { PITCH_REST, QUARTER }, { PITCH_E4, EIGHTH },
+    { PITCH_REST, WHOLE }
 };
 
 //------------------------------------------------------------------------------
@@ -151,27 +94,15 @@ const int durations_SubwaySurfers[] = {
 //------------------------------------------------------------------------------
 
 /**
- * @brief Melody array for The Simpsons theme.
- * @details Contains frequency values for each note in The Simpsons theme song.
- */
-const int melody_TheSimpsons[] = {
-    NOTE_C4, NOTE_E4, NOTE_FS4, REST, NOTE_A4,
-    NOTE_G4, NOTE_E4, NOTE_C4, NOTE_A3,
-    NOTE_FS3, NOTE_FS3, NOTE_FS3, NOTE_G3, REST,
-    NOTE_FS3, NOTE_FS3, NOTE_FS3, NOTE_G3, NOTE_AS3,
-    NOTE_B3, REST
-};
-
-/**
- * @brief Duration array for The Simpsons theme.
- * @details Contains duration values corresponding to each note in melody_TheSimpsons.
+ * @brief Notes of The Simpsons theme, stored in flash.
+ * @details Each note is a pitch index in pitch_tab and a duration code.
  */
-const int durations_TheSimpsons[] = {
-    2, 4, 4, 32, 8,
-    2, 4, 4, 8,
-    8, 8, 8, 4, 2,
-    8, 8, 8, 4, 2,
-    2, 2
+const songNote_t song_TheSimpsons[] PROGMEM = {
+    { PITCH_C4, HALF }, { PITCH_E4, QUARTER }, { PITCH_FS4, QUARTER }, { PITCH_REST, THIRTY_SECOND }, { PITCH_A4, EIGHTH },
+    { PITCH_G4, HALF }, { PITCH_E4, QUARTER }, { PITCH_C4, QUARTER }, { PITCH_A3, EIGHTH },
+    { PITCH_FS3, EIGHTH }, { PITCH_FS3, EIGHTH }, { PITCH_FS3, EIGHTH }, { PITCH_G3, QUARTER }, { PITCH_REST, HALF },
+    { PITCH_FS3, EIGHTH }, { PITCH_FS3, EIGHTH }, { PITCH_FS3, EIGHTH }, { PITCH_G3, QUARTER }, { PITCH_AS3, HALF },
+    { PITCH_B3, HALF }, { PITCH_REST, HALF }
 };
 
 //------------------------------------------------------------------------------
@@ -179,37 +110,22 @@ const int durations_TheSimpsons[] = {
 //------------------------------------------------------------------------------
 
 /**
- * @brief Size array for music tabs.
- * @details Contains size information for each music tab.
+ * @brief Header of every music track, stored in flash.
+ * @details In the order of songId_t. The track played is selected by the song of the current mode in ledPatterns.
  */
-const int* const size_tab[] = {
-    sizeof(durations_PinkPanther) / sizeof(int),
-    sizeof(durations_Nokia) / sizeof(int),
-    sizeof(durations_SubwaySurfers) / sizeof(int),
-    sizeof(durations_TheSimpsons) / sizeof(int)
+const song_t song_tab[] PROGMEM = {
+    SONG(song_PinkPanther, 1000),
+    SONG(song_Nokia, 1000),
+    SONG(song_SubwaySurfers, 1000),
+    SONG(song_TheSimpsons, 1000)
 };
 
 /**
- * @brief Duration array for music tabs.
- * @details Contains duration values for each note in the music tabs.
+ * @brief Number of music tracks in song_tab.
  */
-const int* const durations_tab[] = {
-    durations_PinkPanther,
-    durations_Nokia,
-    durations_SubwaySurfers,
-    durations_TheSimpsons
-};
+const uint8_t song_tab_size = sizeof(song_tab) / sizeof(song_t);
 
-/**
- * @brief Melody array for music tabs.
- * @details Contains frequency values for each note in the music tabs.
- */
-const int* const melody_tab[] = {
-    melody_PinkPanther,
-    melody_Nokia,
-    melody_SubwaySurfers,
-    melody_TheSimpsons
-};
+static_assert(sizeof(song_tab) / sizeof(song_t) == SONG_COUNT, "song_tab must have one track per songId_t");
 
 
 //=============================================================================
@@ -218,48 +134,51 @@ const int* const melody_tab[] = {
 
 /**
  * @brief Main buzzer control function.
- * @details Handles the buzzer output and note playing functionality based on current mode.
+ * @details Keeps the tone engine queue filled with the next notes of the track matching the current mode.
+ *          The notes themselves are played by the Timer1 ISR, so this function never blocks and its timing does not
+ *          affect the music. Each note is followed by a silence of 20% of its duration to distinguish the notes.
+ * @see toneEnginePushNote()
  */
-
- // Modify the buzz function to reset note counter on mode change
 void buzz(){
     static int previous_mode = -1;
-    
-    if (mode >= 0 && mode < 8) {
 
+    // Reset note and flush the queued notes when mode changes
+    if (previous_mode != mode) {
         #ifdef DEBUG_BUZZER
-        debug.printf("Mode in buzzer: %d ", mode);
+        logEvent(LOG_BUZZER_MODE, mode);
         #endif
-        
-        // mode variable modulo 4 in order to have 2 patterns per music
-        int scaled_mode = mode % 4;
-        
-        // Reset note when mode changes
-        if (previous_mode != mode) {
-            note = 0;
-            previous_mode = mode;
-        }
 
-        if (note < size_tab[scaled_mode]) {
-            
-            //to calculate the note duration, take one second divided by the note type
-            //e.g. quarter note = 1000 / 4, eighth note = 1000/8, etc.
-            int duration = 1000 / durations_tab[scaled_mode][note];
-            tone(BUZZER_PIN, melody_tab[scaled_mode][note], duration);
-            
-            //to distinguish the notes, set a minimum time between them
-            //the note's duration + 20% seems to work well
-            int pauseBetweenNotes = duration * 1.20;
-            delay(pauseBetweenNotes);
-
-            //stop the tone playing
-            noTone(BUZZER_PIN);
-            note++;
-        } else {
-            noTone(BUZZER_PIN);
-            delay(100);
+        toneEngineStop();
+        note = 0;
+        previous_mode = mode;
+    }
+
+    if (mode < 0 || mode >= ledPatternCount) {
+        return;
+    }
+
+    // Music of the current mode, if any
+    int8_t songId = (int8_t)pgm_read_byte(&ledPatterns[mode].song);
+    if (songId == NO_SONG) {
+        return;
+    }
+
+    const song_t* song = &song_tab[songId];
+
+    const songNote_t* notes = (const songNote_t*)pgm_read_ptr(&song->notes);
+    uint16_t length = pgm_read_word(&song->length);
+    uint16_t wholeNote = pgm_read_word(&song->wholeNote);
+
+    while (note < length) {
+
+        //the note duration is the whole note duration divided by the note type
+        //e.g. quarter note = whole / 4, eighth note = whole / 8, etc.
+        uint16_t duration = wholeNote >> pgm_read_byte(&notes[note].duration);
+
+        //the note's duration + 20% seems to work well
+        if (!toneEnginePushNote(pgm_read_byte(&notes[note].pitch), duration, duration / 5)) {
+            break;
         }
-    } else {
-        delay(100);
+        note++;
     }
-}
\ No newline at end of file
+}
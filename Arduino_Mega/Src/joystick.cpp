@@ -13,6 +13,10 @@
 
 #include "../Inc/joystick.h"
 
+#include "../Inc/profiler.h"
+
+#include "../Inc/logger.h"
+
 //=============================================================================
 //                             VARIABLE DEFINITIONS
 //=============================================================================
@@ -28,15 +32,122 @@ const unsigned int debounceDelay = 50;
 */
 joystickInput_t JOYSTICK_INPUT = NO_JOYSTICK;
 
+/**
+ * @brief Latest filtered samples of the hardware joystick axes (X, Y), in [0; MAX_POSITION], updated by the ADC interrupt.
+ */
+volatile uint16_t joystickAdcValues[2] = { DEFAULT_POSITION, DEFAULT_POSITION };
+
+/**
+ * @brief Sums of the samples of the current oversampling window of each axis.
+ */
+static uint16_t joystickAdcSums[2] = { 0, 0 };
+
+/**
+ * @brief Number of samples in the current oversampling window of each axis.
+ */
+static uint8_t joystickAdcCounts[2] = { 0, 0 };
+
+/**
+ * @brief Axis being converted by the ADC (0 for X, 1 for Y).
+ */
+static uint8_t joystickAdcAxis = 0;
+
+/**
+ * @brief Number of debounced switch presses not handled yet by readJoystickSwitch(), incremented by the switch interrupt.
+ */
+static volatile uint8_t switchPresses = 0;
+
+/**
+ * @brief Time of the last edge of the switch pin (ms), used by the switch interrupt to debounce.
+ */
+static volatile unsigned long switchLastEdgeTime = 0;
+
 //=============================================================================
 //                             ROUTINE DEFINITIONS
 //=============================================================================
 
+/**
+ * @brief Selects the ADC channel of an axis, with AVcc as reference.
+ * @param axis Axis to convert next (0 for X, 1 for Y).
+ */
+static inline void selectJoystickAdcChannel(uint8_t axis) {
+    ADMUX = _BV(REFS0) | (axis ? JOYSTICK_ADC_CHANNEL_Y : JOYSTICK_ADC_CHANNEL_X);
+}
+
+/**
+ * @brief Starts the background acquisition of the hardware joystick axes.
+ * @details The ADC conversions are chained by the ADC interrupt, which alternates between both axes and averages
+ *          JOYSTICK_OVERSAMPLING samples per axis. analogRead() must not be used while the acquisition is running.
+ */
+void joystickAdcBegin() {
+    // Disable the digital input buffers of the analog pins to reduce noise
+    DIDR0 |= _BV(ADC0D) | _BV(ADC1D);
+
+    joystickAdcAxis = 0;
+    selectJoystickAdcChannel(joystickAdcAxis);
+    ADCSRB &= ~_BV(MUX5);
+
+    // Enable the ADC with its interrupt, 16 MHz / 128 = 125 kHz ADC clock, and start the first conversion
+    ADCSRA = _BV(ADEN) | _BV(ADIE) | _BV(ADPS2) | _BV(ADPS1) | _BV(ADPS0) | _BV(ADSC);
+}
+
+/**
+ * @brief ADC conversion complete interrupt: accumulates the sample, switches to the other axis and starts the next conversion.
+ * @details Conversions are started from the interrupt rather than in free-running mode, so that the channel change
+ *          applies to the very next conversion and no sample has to be discarded.
+ */
+ISR(ADC_vect) {
+    uint8_t axis = joystickAdcAxis;
+
+    joystickAdcSums[axis] += ADC;
+
+    if (++joystickAdcCounts[axis] == JOYSTICK_OVERSAMPLING) {
+        joystickAdcValues[axis] = joystickAdcSums[axis] / JOYSTICK_OVERSAMPLING;
+        joystickAdcSums[axis] = 0;
+        joystickAdcCounts[axis] = 0;
+    }
+
+    joystickAdcAxis = axis ^ 1;
+    selectJoystickAdcChannel(joystickAdcAxis);
+    ADCSRA |= _BV(ADSC);
+}
+
+/**
+* @brief Enables the external interrupt capturing the joystick switch edges.
+* @details Must be called after the switch pin is configured as an input with pull-up.
+*/
+void joystickSwitchBegin() {
+    switchLastEdgeTime = millis();
+
+    // Interrupt on any edge of INT5, clear a pending request before enabling it
+    EICRB = (EICRB & ~(_BV(ISC51) | _BV(ISC50))) | _BV(ISC50);
+    EIFR = _BV(INTF5);
+    EIMSK |= _BV(INT5);
+}
+
+/**
+* @brief Switch pin change interrupt: timestamps the edge and posts a press event.
+* @details A falling edge is a press only if the pin was stable for at least debounceDelay before it,
+*          so the bounces of both the press and the release are ignored.
+*/
+ISR(INT5_vect) {
+    unsigned long now = millis();
+
+    if (!(SW_PIN_REG & _BV(SW_BIT)) && now - switchLastEdgeTime > debounceDelay && switchPresses < UINT8_MAX) {
+        switchPresses++;
+    }
+
+    switchLastEdgeTime = now;
+}
+
 /**
  * @brief Reads and processes joystick input to control motor speeds and directions.
  * @details Reads joystick input from either Bluetooth or hardware sources, scales the input, and computes the appropriate motor drive modes and speeds. 
- * If the joystick input indicates that the motors should be updated, it calls the `computeDriveModesAndSpeeds()` and `applyMotorsSettings()` functions to update the motor states.
- * @see computeDriveModesAndSpeeds(
+ * If the joystick input indicates that the motors should be updated, it calls the `computeDriveModesAndSpeeds()` function to update the motor targets.
+ * If no valid Bluetooth command was received for BT_COMMAND_TIMEOUT, the motor targets are set to STOPPED.
+ * The motor task ramps the motor states toward the targets and applies them to the motors, see `updateMotorsRamp()` and `applyMotorsSettings()`.
+ * @see computeDriveModesAndSpeeds()
+ * @see updateMotorsRamp()
  * @see applyMotorsSettings()
  */
 void readJoystick() {
@@ -44,30 +155,47 @@ void readJoystick() {
   int scaled_X, scaled_Y;
 
   bool shouldUpdateMotors = false;
+
+  readJoystickSwitch();
   
   switch (JOYSTICK_INPUT){
     case BLUETOOTH:
-        shouldUpdateMotors = BT_process(&scaled_X, &scaled_Y);
+        {
+          PROFILE_START(PROFILE_BT);
+          shouldUpdateMotors = BT_process(&scaled_X, &scaled_Y);
+          PROFILE_STOP(PROFILE_BT);
+
+          // The latency starts when the last byte of the command was received
+          if (shouldUpdateMotors) {
+            PROFILE_SPAN_START(PROFILE_LATENCY, BlueT.readTime());
+          }
+        }
         break;
 
     case HARDWARE:
-        readJoystickSwitch();
         readAndScaleHardwareJoystick(&scaled_X, &scaled_Y);
+        shouldUpdateMotors = true;
+        PROFILE_SPAN_START(PROFILE_LATENCY, micros());
         break;
 
     case NO_JOYSTICK:
-        return; 
+        break;
+  }
+
+  // Failsafe: stop the robot when the remote has been silent for too long, the motor ramp slows it down
+  if (JOYSTICK_INPUT != HARDWARE && !shouldUpdateMotors && BT_checkTimeout()) {
+    scaled_X = 0;
+    scaled_Y = 0;
+    shouldUpdateMotors = true;
   }
   
   if (shouldUpdateMotors){
     
     #ifdef DEBUG_MOTORS
-    debug.printf("(scaled_X, scaled_Y) = (%d,%d)\n", scaled_X, scaled_Y);
+    logEvent(LOG_SCALED_INPUT, scaled_X, scaled_Y);
     #endif
     
     computeDriveModesAndSpeeds(scaled_X, scaled_Y);
-    
-    applyMotorsSettings();
   }
 }
 
@@ -79,13 +207,15 @@ void readJoystick() {
  */
 void readAndScaleHardwareJoystick(int* scaled_X, int* scaled_Y) {
   
-  readJoystickSwitch();
-  
-  int X = analogRead(A0);  
-  int Y = analogRead(A1);
+  // 16-bit values written by the ADC interrupt
+  uint8_t oldSREG = SREG;
+  cli();
+  int X = joystickAdcValues[0];
+  int Y = joystickAdcValues[1];
+  SREG = oldSREG;
 
   #ifdef DEBUG_JOYSTICK
-  debug.printf("(X, Y) = (%d,%d)\n", X, Y);
+  logEvent(LOG_HARDWARE_INPUT, X, Y);
   #endif
   
   *scaled_X = X - DEFAULT_POSITION;
@@ -94,49 +224,114 @@ void readAndScaleHardwareJoystick(int* scaled_X, int* scaled_Y) {
 
 /**
 * @brief Handles joystick button state.
-* @details Implements debounce logic and mode switching.
+* @details Consumes the presses captured and debounced by the switch interrupt, and switches the mode once per press.
 */
 void readJoystickSwitch() {
 
-  // Last time the joystick button state was debounced. Used for timing in the debounce mechanism.
-  static unsigned long lastDebounceTime = 0;
+  // Take the pending presses, the counter is also written by the interrupt
+  uint8_t oldSREG = SREG;
+  cli();
+  uint8_t presses = switchPresses;
+  switchPresses = 0;
+  SREG = oldSREG;
 
-  // Previous state of the joystick button. Used to detect changes in button state.
-  static int lastButtonState = HIGH;
+  while (presses--) {
+    updateMode();
+    note = 0;
 
-  // Current debounced state of the joystick button. Represents the validated button state after debouncing.
-  static int buttonState;
+    #if defined(DEBUG_JOYSTICK) || defined(DEBUG_STRIP_LED)
+    logEvent(LOG_SWITCH_PRESSED, mode);
+    #endif
+  }
+}
 
-  // Read the current state of the joystick button.
-  int SW_value = digitalRead(SW);
-  
-  if (SW_value != lastButtonState) {
-    lastDebounceTime = millis();
+/**
+ * @brief Converts a signed mixed wheel command to a drive mode and a PWM speed.
+ * @param command Mixed wheel command, in [- DEFAULT_POSITION; DEFAULT_POSITION].
+ * @param driveMode Pointer to the drive mode to update.
+ * @param motorSpeed Pointer to the motor speed to update.
+ */
+static void applyWheelCommand(int command, driveMode_t* driveMode, uint8_t* motorSpeed) {
+  uint16_t magnitude = (command < 0) ? - command : command;
+
+  if (magnitude > DEFAULT_POSITION) {
+    magnitude = DEFAULT_POSITION;
   }
-  
-  if ((millis() - lastDebounceTime) > debounceDelay) {
-    if (SW_value != buttonState) {
-      buttonState = SW_value;
-      
-      if (buttonState == LOW) {
-        #ifdef DEBUG_JOYSTICK || DEBUG_STRIP_LED
-        debug.printf("Switch pressed, LED pattern updating... \n");
-        #endif
-        updateMode();
-        note = 0;
-      }
-    }
-  } 
-  lastButtonState = SW_value;
+
+  *motorSpeed = (magnitude * MOTOR_SCALE_Q8) >> 8;
+
+  if (*motorSpeed == 0) {
+    *driveMode = STOPPED;
+  } else {
+    *driveMode = (command > 0) ? FORWARD : BACKWARDS;
+  }
+}
+
+/**
+ * @brief Computes the target drive modes and speeds for the left and right motors based on the scaled joystick input.
+ * @param scaled_X The scaled X-axis value from the joystick (forward / backward).
+ * @param scaled_Y The scaled Y-axis value from the joystick (turn, right if positive).
+ * @details Integer arcade-drive mixer covering the whole (X, Y) plane:
+ *          - Arc turn: the outer wheel runs at the X speed and the inner wheel is slowed down proportionally to |Y|.
+ *          - Pivot turn: the wheels run in opposite directions at the Y speed.
+ *          The pivot mix is added to the arc turn mix with a weight depending on |X|: pure pivot when X is centered, pure arc turn once |X| reaches PIVOT_LIMIT.
+ *          Values within DEADZONE_EPSILON of the center are ignored on each axis. Only integer and fixed-point arithmetic is used.
+ */
+void computeDriveModesAndSpeeds(int scaled_X, int scaled_Y) {
+
+  // Apply the deadzone on both axes
+  int throttle = (scaled_X > DEADZONE_EPSILON || scaled_X < -DEADZONE_EPSILON) ? constrain(scaled_X, -DEFAULT_POSITION, DEFAULT_POSITION) : 0;
+  int turn = (scaled_Y > DEADZONE_EPSILON || scaled_Y < -DEADZONE_EPSILON) ? constrain(scaled_Y, -DEFAULT_POSITION, DEFAULT_POSITION) : 0;
+
+  // Arc turn: the inner wheel is slowed down, scaled by the throttle
+  long arcL = (turn < 0) ? (long)throttle * (DEFAULT_POSITION + turn) / DEFAULT_POSITION : throttle;
+  long arcR = (turn > 0) ? (long)throttle * (DEFAULT_POSITION - turn) / DEFAULT_POSITION : throttle;
+
+  // Pivot weight in Q8: 256 when the throttle is centered, 0 once it reaches PIVOT_LIMIT
+  uint16_t absThrottle = (throttle < 0) ? - throttle : throttle;
+  int pivotWeight = (absThrottle >= PIVOT_LIMIT) ? 0 : 256 - (absThrottle * 256U) / PIVOT_LIMIT;
+
+  // Pivot component added on top of the arc turn, so that driving straight is not slowed down
+  int pivot = ((long)pivotWeight * turn) >> 8;
+
+  int commandL = arcL + pivot;
+  int commandR = arcR - pivot;
+
+  applyWheelCommand(commandL, &targetDriveModeL, &targetSpeedL);
+  applyWheelCommand(commandR, &targetDriveModeR, &targetSpeedR);
 }
 
 /**
- * @brief Computes the drive modes and speeds for the left and right motors based on the scaled joystick input.
+* @brief Get the name of the specified joystick input.
+* @param joystickInput The joystick input to get the name for.
+* @return The name of the specified joystick input as a String.
+*/
+const char* getJoystickInputName(){
+  switch (JOYSTICK_INPUT) {
+    case HARDWARE:
+        return "HARDWARE";
+    case BLUETOOTH:
+        return "BLUETOOTH";
+    case NO_JOYSTICK:
+        return "NO_JOYSTICK";
+    default:
+        return "Unknown";
+  }
+}
+
+#ifdef BENCHMARK_JOYSTICK
+
+/**
+ * @brief Floating-point scaling factor used by the former mixer.
+ */
+#define LEGACY_SCALING_FACTOR ((float)DEFAULT_POSITION / FULL_SPEED)
+
+/**
+ * @brief Former floating-point mixer, only used as a reference by benchmarkDriveMixer().
  * @param scaled_X The scaled X-axis value from the joystick.
  * @param scaled_Y The scaled Y-axis value from the joystick.
- * @details This function resets the motor states, then determines the appropriate drive mode (forward, backward, or stopped) and speed for the left and right motors based on the scaled joystick input. The function uses a series of conditional statements to handle different combinations of X and Y axis values, applying the appropriate scaling and direction logic to compute the motor speeds.
  */
-void computeDriveModesAndSpeeds(int scaled_X, int scaled_Y) {
+static void computeDriveModesAndSpeedsFloat(int scaled_X, int scaled_Y) {
   
   // Reset motor states
   resetMotorStates();
@@ -146,11 +341,11 @@ void computeDriveModesAndSpeeds(int scaled_X, int scaled_Y) {
     driveModeL = FORWARD;
     
     if (scaled_Y < 0) {
-      motorSpeedR = scaled_X / MOTOR_SCALING_FACTOR;  
-      motorSpeedL = intToUint8_t(scaled_X / MOTOR_SCALING_FACTOR + (scaled_Y / MOTOR_SCALING_FACTOR) / 2);
+      motorSpeedR = scaled_X / LEGACY_SCALING_FACTOR;
+      motorSpeedL = intToUint8_t(scaled_X / LEGACY_SCALING_FACTOR + (scaled_Y / LEGACY_SCALING_FACTOR) / 2);
     } else {
-      motorSpeedR = intToUint8_t(scaled_X / MOTOR_SCALING_FACTOR - (scaled_Y / MOTOR_SCALING_FACTOR) / 2);
-      motorSpeedL = scaled_X  / MOTOR_SCALING_FACTOR;
+      motorSpeedR = intToUint8_t(scaled_X / LEGACY_SCALING_FACTOR - (scaled_Y / LEGACY_SCALING_FACTOR) / 2);
+      motorSpeedL = scaled_X  / LEGACY_SCALING_FACTOR;
     }
   } else {
     if (scaled_X < -DEADZONE_EPSILON) {
@@ -158,23 +353,23 @@ void computeDriveModesAndSpeeds(int scaled_X, int scaled_Y) {
       driveModeL = BACKWARDS;
       
       if (scaled_Y < 0) {
-        motorSpeedL = intToUint8_t(- scaled_X / MOTOR_SCALING_FACTOR + (scaled_Y / MOTOR_SCALING_FACTOR) / 2);
+        motorSpeedL = intToUint8_t(- scaled_X / LEGACY_SCALING_FACTOR + (scaled_Y / LEGACY_SCALING_FACTOR) / 2);
       } else {
-        motorSpeedR = intToUint8_t(- scaled_X / MOTOR_SCALING_FACTOR - (scaled_Y / MOTOR_SCALING_FACTOR) / 2);
-        motorSpeedL = - scaled_X / MOTOR_SCALING_FACTOR;
+        motorSpeedR = intToUint8_t(- scaled_X / LEGACY_SCALING_FACTOR - (scaled_Y / LEGACY_SCALING_FACTOR) / 2);
+        motorSpeedL = - scaled_X / LEGACY_SCALING_FACTOR;
       }
     } else {
       if (scaled_Y < - DEADZONE_EPSILON) {
         driveModeR = FORWARD;
         driveModeL = BACKWARDS;
-        motorSpeedR = - scaled_Y / MOTOR_SCALING_FACTOR;
-        motorSpeedL = - scaled_Y / MOTOR_SCALING_FACTOR;
+        motorSpeedR = - scaled_Y / LEGACY_SCALING_FACTOR;
+        motorSpeedL = - scaled_Y / LEGACY_SCALING_FACTOR;
       } else {
         if (scaled_Y > DEADZONE_EPSILON) {
           driveModeR = BACKWARDS;
           driveModeL = FORWARD;
-          motorSpeedR = scaled_Y / MOTOR_SCALING_FACTOR;
-          motorSpeedL = scaled_Y / MOTOR_SCALING_FACTOR;
+          motorSpeedR = scaled_Y / LEGACY_SCALING_FACTOR;
+          motorSpeedL = scaled_Y / LEGACY_SCALING_FACTOR;
         } else {
           driveModeR = STOPPED;
           driveModeL = STOPPED;
@@ -186,20 +381,46 @@ void computeDriveModesAndSpeeds(int scaled_X, int scaled_Y) {
   }
 }
 
+
 /**
-* @brief Get the name of the specified joystick input.
-* @param joystickInput The joystick input to get the name for.
-* @return The name of the specified joystick input as a String.
-*/
-char* getJoystickInputName(){
-  switch (JOYSTICK_INPUT) {
-    case HARDWARE:
-        return "HARDWARE";
-    case BLUETOOTH:
-        return "BLUETOOTH";
-    case NO_JOYSTICK:
-        return "NO_JOYSTICK";
-    default:
-        return "Unknown";
+ * @brief Prints the output of the former and of the current mixer over a grid of inputs, with the cycles spent by each call.
+ * @details One line per (X, Y) input of the grid, X and Y in [- DEFAULT_POSITION; DEFAULT_POSITION] with a step of 64:
+ *          "X Y | modeL speedL modeR speedR cycles | modeL speedL modeR speedR cycles" (former mixer, then current mixer).
+ */
+void benchmarkDriveMixer() {
+  uint32_t totalFloatCycles = 0;
+  uint32_t totalFixedCycles = 0;
+  uint16_t samples = 0;
+
+  for (int X = -DEFAULT_POSITION; X <= DEFAULT_POSITION; X += 64) {
+    for (int Y = -DEFAULT_POSITION; Y <= DEFAULT_POSITION; Y += 64) {
+
+      startCycleCounter();
+      computeDriveModesAndSpeedsFloat(X, Y);
+      uint32_t floatCycles = readCycleCounter();
+
+      debug.printf("%d %d | %d %d %d %d ", X, Y, driveModeL, motorSpeedL, driveModeR, motorSpeedR);
+      Serial.print(floatCycles);
+
+      startCycleCounter();
+      computeDriveModesAndSpeeds(X, Y);
+      uint32_t fixedCycles = readCycleCounter();
+
+      debug.printf(" | %d %d %d %d ", targetDriveModeL, targetSpeedL, targetDriveModeR, targetSpeedR);
+      Serial.println(fixedCycles);
+
+      totalFloatCycles += floatCycles;
+      totalFixedCycles += fixedCycles;
+      samples++;
+    }
   }
-}
\ No newline at end of file
+
+  Serial.print("Mean cycles: float ");
+  Serial.print(totalFloatCycles / samples);
+  Serial.print(", fixed-point ");
+  Serial.println(totalFixedCycles / samples);
+
+  resetMotorStates();
+}
+
+#endif
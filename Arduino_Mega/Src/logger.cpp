@@ -0,0 +1,140 @@
+/**
+ * @file logger.cpp
+ * @brief Source file containing the deferred binary logging implementation.
+ * @details The records are stored in a RAM ring buffer by logEvent() and sent by logDrain() when the CPU is idle.
+ */
+
+//=============================================================================
+//                       INCLUDE LIBRARIES AND HEADER FILES
+//=============================================================================
+
+#include "../Inc/logger.h"
+
+//=============================================================================
+//                             VARIABLE DEFINITIONS
+//=============================================================================
+
+/**
+ * @brief Ring buffer of the records waiting to be sent.
+ */
+static logRecord_t logBuffer[LOG_BUFFER_SIZE];
+
+/**
+ * @brief Index of the next free slot of the ring buffer.
+ */
+static uint8_t logHead = 0;
+
+/**
+ * @brief Index of the next record to send.
+ */
+static uint8_t logTail = 0;
+
+/**
+ * @brief Number of records dropped because the ring buffer was full, reported with a LOG_DROPPED record.
+ * @details Saturates at INT16_MAX, the largest value of a record argument.
+ */
+static uint16_t logDroppedCount = 0;
+
+/**
+ * @brief Serial frame of the record being sent.
+ */
+static uint8_t logFrame[LOG_FRAME_SIZE];
+
+/**
+ * @brief Number of bytes of logFrame already sent, LOG_FRAME_SIZE if there is no frame being sent.
+ */
+static uint8_t logFrameSent = LOG_FRAME_SIZE;
+
+//=============================================================================
+//                             ROUTINE DEFINITIONS
+//=============================================================================
+
+/**
+ * @brief Stores a record in the ring buffer.
+ * @param event Event id.
+ * @param arg0 First argument.
+ * @param arg1 Second argument.
+ * @return True if the record was stored, false if the buffer is full.
+ */
+static bool pushRecord(logEvent_t event, int16_t arg0, int16_t arg1) {
+    uint8_t next = (logHead + 1) & (LOG_BUFFER_SIZE - 1);
+
+    if (next == logTail) {
+        return false;
+    }
+
+    logRecord_t* record = &logBuffer[logHead];
+    record->event = event;
+    record->timestamp = millis();
+    record->args[0] = arg0;
+    record->args[1] = arg1;
+
+    logHead = next;
+    return true;
+}
+
+/**
+ * @brief Encodes a record into logFrame.
+ * @param record Record to encode.
+ */
+static void encodeRecord(const logRecord_t* record) {
+    logFrame[0] = LOG_MARKER;
+    logFrame[1] = record->event;
+
+    for (uint8_t i = 0; i < 4; i++) {
+        logFrame[2 + i] = record->timestamp >> (8 * i);
+    }
+
+    for (uint8_t i = 0; i < 2; i++) {
+        logFrame[6 + 2 * i] = record->args[i];
+        logFrame[7 + 2 * i] = (uint16_t)record->args[i] >> 8;
+    }
+
+    uint8_t checksum = 0;
+    for (uint8_t i = 1; i < LOG_FRAME_SIZE - 1; i++) {
+        checksum ^= logFrame[i];
+    }
+    logFrame[LOG_FRAME_SIZE - 1] = checksum;
+
+    logFrameSent = 0;
+}
+
+/**
+ * @brief Stores an event in the ring buffer. The event is dropped if the buffer is full.
+ * @param event Event id.
+ * @param arg0 First argument.
+ * @param arg1 Second argument.
+ */
+void logEvent(logEvent_t event, int16_t arg0, int16_t arg1) {
+    if (!pushRecord(event, arg0, arg1) && logDroppedCount < INT16_MAX) {
+        logDroppedCount++;
+    }
+}
+
+/**
+ * @brief Sends the buffered records on the serial port, without waiting: only the bytes fitting in the serial transmit buffer are written.
+ * @details Must be called when the CPU is idle.
+ */
+void logDrain() {
+    int room = Serial.availableForWrite();
+
+    while (room > 0) {
+
+        if (logFrameSent == LOG_FRAME_SIZE) {
+            // Report the dropped records as soon as there is room for it
+            if (logDroppedCount != 0 && pushRecord(LOG_DROPPED, logDroppedCount, 0)) {
+                logDroppedCount = 0;
+            }
+
+            if (logTail == logHead) {
+                return;
+            }
+
+            encodeRecord(&logBuffer[logTail]);
+            logTail = (logTail + 1) & (LOG_BUFFER_SIZE - 1);
+        }
+
+        Serial.write(logFrame[logFrameSent++]);
+        room--;
+    }
+}
@@ -12,10 +12,92 @@
 
 #include "../Inc/motor.h"
 
+#include "../Inc/logger.h"
+
+//=============================================================================
+//                                   MACROS
+//=============================================================================
+
+/**
+ * @brief Output register of the motor direction pins.
+ * @details IN_1 to IN_4 (pins 6 to 9) are PH3 to PH6 on the ATmega2560, so both motors are set with one register write.
+ */
+#define MOTOR_DIR_PORT PORTH
+
+#if MOTOR_PWM_PRESCALER == 1
+#define MOTOR_PWM_CLOCK_TIMER2 _BV(CS20)
+#define MOTOR_PWM_CLOCK_TIMER3 _BV(CS30)
+#elif MOTOR_PWM_PRESCALER == 8
+#define MOTOR_PWM_CLOCK_TIMER2 _BV(CS21)
+#define MOTOR_PWM_CLOCK_TIMER3 _BV(CS31)
+#elif MOTOR_PWM_PRESCALER == 64
+#define MOTOR_PWM_CLOCK_TIMER2 _BV(CS22)
+#define MOTOR_PWM_CLOCK_TIMER3 (_BV(CS31) | _BV(CS30))
+#else
+#error "MOTOR_PWM_PRESCALER must be 1, 8 or 64"
+#endif
+
+/**
+ * @brief Bit of MOTOR_DIR_PORT driven by an Arduino pin, 0xFF if the pin is not on this port.
+ * @param pin Arduino pin number.
+ */
+constexpr uint8_t motorDirectionBit(uint8_t pin) {
+  return pin == 6 ? PH3 : pin == 7 ? PH4 : pin == 8 ? PH5 : pin == 9 ? PH6 : 0xFF;
+}
+
+static_assert(motorDirectionBit(IN_1) != 0xFF && motorDirectionBit(IN_2) != 0xFF
+              && motorDirectionBit(IN_3) != 0xFF && motorDirectionBit(IN_4) != 0xFF,
+              "IN_1 to IN_4 must be pins 6 to 9 (PORTH)");
+
+static_assert(EN_A == 10 && EN_B == 5, "EN_A must be pin 10 (OC2A) and EN_B pin 5 (OC3A)");
+
+/**
+ * @brief Direction pin levels of the left motor for each drive mode, indexed by driveMode_t.
+ */
+constexpr uint8_t MOTOR_DIR_L[] = {
+  0,                                /**< STOPPED: IN_3 and IN_4 low */
+  _BV(motorDirectionBit(IN_3)),     /**< BACKWARDS: IN_3 high */
+  _BV(motorDirectionBit(IN_4))      /**< FORWARD: IN_4 high */
+};
+
+/**
+ * @brief Direction pin levels of the right motor for each drive mode, indexed by driveMode_t.
+ */
+constexpr uint8_t MOTOR_DIR_R[] = {
+  0,                                /**< STOPPED: IN_1 and IN_2 low */
+  _BV(motorDirectionBit(IN_1)),     /**< BACKWARDS: IN_1 high */
+  _BV(motorDirectionBit(IN_2))      /**< FORWARD: IN_2 high */
+};
+
+/**
+ * @brief Mask of all the direction pins in MOTOR_DIR_PORT.
+ */
+constexpr uint8_t MOTOR_DIR_MASK = MOTOR_DIR_L[BACKWARDS] | MOTOR_DIR_L[FORWARD] | MOTOR_DIR_R[BACKWARDS] | MOTOR_DIR_R[FORWARD];
+
 //=============================================================================
 //                             VARIABLE DEFINITIONS
 //=============================================================================
 
+/**
+* @brief Left motor target PWM speed, set by the joystick mixer. Must be between 0 and 255.
+*/
+uint8_t targetSpeedL = 0;
+
+/**
+* @brief Right motor target PWM speed, set by the joystick mixer. Must be between 0 and 255.
+*/
+uint8_t targetSpeedR = 0;
+
+/**
+* @brief Left motor target drive mode, set by the joystick mixer.
+*/
+driveMode_t targetDriveModeL = STOPPED;
+
+/**
+* @brief Right motor target drive mode, set by the joystick mixer.
+*/
+driveMode_t targetDriveModeR = STOPPED;
+
 /**
 * @brief Left motor PWM speed. Must be between 0 and 255.
 * Limited by 
@@ -37,78 +119,135 @@ driveMode_t driveModeL = STOPPED;
 */
 driveMode_t driveModeR = STOPPED;
 
+/**
+* @brief Direction pin levels last written to MOTOR_DIR_PORT, 0xFF to force the next write.
+*/
+static uint8_t appliedDirections = 0xFF;
+
+/**
+* @brief Last written speeds (left, right), -1 to force the next write.
+*/
+static int appliedSpeedL = -1;
+static int appliedSpeedR = -1;
+
 //=============================================================================
 //                             ROUTINE DEFINITIONS
 //=============================================================================
 
 
 /**
-* @brief Resets both motor states to default values (switched-off).
+ * @brief Configures the PWM timers of the enable pins and forces the next settings to be written to the outputs.
+ * @details Must be called after the motor pins are configured as outputs.
+ * @note Timer2 and Timer3 are dedicated to the motors, their other PWM pins (2, 3 and 9) must not be used with analogWrite().
+ */
+void motorOutputBegin() {
+  // Phase-correct 8-bit PWM on OC2A (EN_A) and OC3A (EN_B), non-inverting: OCR = 0 keeps the output low, OCR = 255 high
+  OCR2A = 0;
+  TCCR2A = _BV(COM2A1) | _BV(WGM20);
+  TCCR2B = MOTOR_PWM_CLOCK_TIMER2;
+
+  OCR3A = 0;
+  TCCR3A = _BV(COM3A1) | _BV(WGM30);
+  TCCR3B = MOTOR_PWM_CLOCK_TIMER3;
+
+  appliedDirections = 0xFF;
+  appliedSpeedL = -1;
+  appliedSpeedR = -1;
+}
+
+/**
+* @brief Resets both motor states and targets to default values (switched-off).
 */
 void resetMotorStates() {
   driveModeR = STOPPED;
   driveModeL = STOPPED;
   motorSpeedR = 0;
   motorSpeedL = 0;
+  targetDriveModeR = STOPPED;
+  targetDriveModeL = STOPPED;
+  targetSpeedR = 0;
+  targetSpeedL = 0;
+}
+
+/**
+* @brief Moves the speed and drive mode of one motor one control period toward their target.
+* @param targetDriveMode Target drive mode.
+* @param targetSpeed Target speed.
+* @param driveMode Pointer to the drive mode to update.
+* @param motorSpeed Pointer to the speed to update.
+*/
+static void rampMotor(driveMode_t targetDriveMode, uint8_t targetSpeed, driveMode_t* driveMode, uint8_t* motorSpeed) {
+
+  // Reversing: slow down to a stop before switching direction
+  if (*driveMode != STOPPED && targetDriveMode != *driveMode) {
+    targetSpeed = 0;
+  }
+
+  if (targetSpeed > *motorSpeed) {
+    *motorSpeed = (targetSpeed - *motorSpeed > MOTOR_ACCELERATION_STEP) ? *motorSpeed + MOTOR_ACCELERATION_STEP : targetSpeed;
+  } else {
+    *motorSpeed = (*motorSpeed - targetSpeed > MOTOR_DECELERATION_STEP) ? *motorSpeed - MOTOR_DECELERATION_STEP : targetSpeed;
+  }
+
+  // The new direction is only taken once the motor is stopped, for at least one control period
+  if (*motorSpeed == 0) {
+    *driveMode = STOPPED;
+  } else if (*driveMode == STOPPED) {
+    *driveMode = targetDriveMode;
+  }
+}
+
+/**
+* @brief Moves the motor speeds and drive modes one control period toward their targets.
+* @details Must be called every MOTOR_CONTROL_PERIOD. The speeds change by at most MOTOR_ACCELERATION_STEP when speeding up
+*          and MOTOR_DECELERATION_STEP when slowing down. A motor reversing its direction is slowed down to STOPPED first.
+*/
+void updateMotorsRamp() {
+  rampMotor(targetDriveModeL, targetSpeedL, &driveModeL, &motorSpeedL);
+  rampMotor(targetDriveModeR, targetSpeedR, &driveModeR, &motorSpeedR);
 }
 
 /**
 * @brief Applies current speed settings to both motors.
+* @details The duty cycles are written to the PWM compare registers, only when they changed.
 */
 void applyMotorsSpeed() {
   
+  if (motorSpeedR == appliedSpeedR && motorSpeedL == appliedSpeedL) {
+    return;
+  }
+
   // set PWM value for both motors
-  analogWrite(EN_A, motorSpeedR);
-  analogWrite(EN_B, motorSpeedL);
+  OCR2A = motorSpeedR;
+  OCR3A = motorSpeedL;
+
+  appliedSpeedR = motorSpeedR;
+  appliedSpeedL = motorSpeedL;
   
   #ifdef DEBUG_MOTORS
-  debug.printf("Updated motors speed (L,R): ( %d , %d )\n", motorSpeedL, motorSpeedR);
+  logEvent(LOG_MOTORS_SPEED, motorSpeedL, motorSpeedR);
   #endif
 }
 
 /**
 * @brief Applies current drive mode settings to both motors.
+* @details The four direction pins are written with a single port update, only when a drive mode changed.
 */
 void applyDriveModes() {
   
-  // modify drive mode for the left motor
-  switch (driveModeL) {
-    
-    case FORWARD:
-        digitalWrite(IN_3, LOW);
-        digitalWrite(IN_4, HIGH);
-        break;
-    
-    case BACKWARDS:
-        digitalWrite(IN_3, HIGH);
-        digitalWrite(IN_4, LOW);
-        break;
-    
-    case STOPPED:
-        digitalWrite(IN_3, LOW);
-        digitalWrite(IN_4, LOW);
-  }
-  
-  // modify drive mode for the right motor
-  switch (driveModeR) {
-    
-    case FORWARD:
-        digitalWrite(IN_1, LOW);
-        digitalWrite(IN_2, HIGH);
-        break;
-    
-    case BACKWARDS:
-        digitalWrite(IN_1, HIGH);
-        digitalWrite(IN_2, LOW);
-        break;
-    
-    case STOPPED:
-        digitalWrite(IN_1, LOW);
-        digitalWrite(IN_2, LOW);
+  uint8_t directions = MOTOR_DIR_L[driveModeL] | MOTOR_DIR_R[driveModeR];
+
+  if (directions == appliedDirections) {
+    return;
   }
+
+  // Not atomic: no interrupt may write the other pins of this port
+  MOTOR_DIR_PORT = (MOTOR_DIR_PORT & ~MOTOR_DIR_MASK) | directions;
+
+  appliedDirections = directions;
   
   #ifdef DEBUG_MOTORS
-  debug.printf("Updated motors modes (L,R): ( %s , %s )\n", getDirectionName(driveModeL), getDirectionName(driveModeR));
+  logEvent(LOG_MOTORS_MODES, driveModeL, driveModeR);
   #endif
 }
 
@@ -126,7 +265,7 @@ void applyMotorsSettings() {
 * @param direction The drive mode to convert.
 * @return Corresponding direction name.
 */
-char* getDirectionName(driveMode_t direction) {
+const char* getDirectionName(driveMode_t direction) {
   switch (direction) {
     case 0:
         return "STOPPED";
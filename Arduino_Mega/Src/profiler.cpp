@@ -0,0 +1,195 @@
+/**
+ * @file profiler.cpp
+ * @brief Source file containing the timing instrumentation implementation.
+ * @details Only compiled in when PROFILE_TIMING is defined.
+ */
+
+//=============================================================================
+//                       INCLUDE LIBRARIES AND HEADER FILES
+//=============================================================================
+
+#include "../Inc/profiler.h"
+
+#ifdef PROFILE_TIMING
+
+//=============================================================================
+//                              TYPE DECLARATIONS
+//=============================================================================
+
+/**
+ * @brief Timing statistics of one subsystem.
+ */
+typedef struct profileStats_t {
+    unsigned long min;                      /**< Shortest duration (µs) */
+    unsigned long max;                      /**< Longest duration (µs) */
+    unsigned long sum;                      /**< Sum of the durations (µs), for the mean */
+    uint16_t count;                         /**< Number of measures */
+    uint16_t histogram[PROFILE_BUCKETS];    /**< Number of measures per log2 bucket */
+} profileStats_t;
+
+//=============================================================================
+//                             VARIABLE DEFINITIONS
+//=============================================================================
+
+/**
+ * @brief Timing statistics of every subsystem.
+ */
+static profileStats_t profileStats[PROFILE_COUNT];
+
+/**
+ * @brief Names of the measured subsystems, in the order of profileId_t.
+ */
+static const char* const profileNames[PROFILE_COUNT] = {
+    "loop period",
+    "input",
+    "BT_process",
+    "motors",
+    "LED",
+    "pixels.show",
+    "buzzer",
+    "input to PWM"
+};
+
+/**
+ * @brief Start time of the pending span of each subsystem (µs).
+ */
+static unsigned long spanStarts[PROFILE_COUNT];
+
+/**
+ * @brief Whether a span of each subsystem is pending.
+ */
+static bool spanPending[PROFILE_COUNT];
+
+//=============================================================================
+//                             ROUTINE DEFINITIONS
+//=============================================================================
+
+/**
+ * @brief Records one measured duration of a subsystem.
+ * @param id Measured subsystem.
+ * @param duration Measured duration (µs).
+ */
+void profileRecord(profileId_t id, unsigned long duration) {
+    profileStats_t* stats = &profileStats[id];
+
+    // Stop accumulating once the counters are full, until the next dump
+    if (stats->count == UINT16_MAX) {
+        return;
+    }
+
+    if (stats->count == 0 || duration < stats->min) {
+        stats->min = duration;
+    }
+
+    if (duration > stats->max) {
+        stats->max = duration;
+    }
+
+    stats->sum += duration;
+    stats->count++;
+
+    // Number of significant bits of the duration
+    uint8_t bucket = 0;
+    while (duration != 0 && bucket < PROFILE_BUCKETS - 1) {
+        duration >>= 1;
+        bucket++;
+    }
+
+    stats->histogram[bucket]++;
+}
+
+/**
+ * @brief Starts measuring a span that ends in another routine. Ignored if a span of the same id is pending.
+ * @param id Measured span.
+ * @param start Start time of the span (µs).
+ */
+void profileSpanStart(profileId_t id, unsigned long start) {
+    if (!spanPending[id]) {
+        spanStarts[id] = start;
+        spanPending[id] = true;
+    }
+}
+
+/**
+ * @brief Stops measuring a span and records its duration, if one is pending.
+ * @param id Measured span.
+ */
+void profileSpanStop(profileId_t id) {
+    if (spanPending[id]) {
+        spanPending[id] = false;
+        profileRecord(id, micros() - spanStarts[id]);
+    }
+}
+
+/**
+ * @brief Gets the upper bound of the histogram bucket holding a percentile of the measures.
+ * @param stats Statistics of the subsystem, with at least one measure.
+ * @param percent Percentile, in [1; 100].
+ * @return Upper bound of the bucket (µs), 0 if the percentile is in the last bucket, which has no upper bound.
+ */
+static unsigned long percentileBound(const profileStats_t* stats, uint8_t percent) {
+    // Rank of the percentile, rounded up
+    unsigned long rank = ((unsigned long)stats->count * percent + 99) / 100;
+    unsigned long cumulated = 0;
+
+    for (uint8_t bucket = 0; bucket < PROFILE_BUCKETS - 1; bucket++) {
+        cumulated += stats->histogram[bucket];
+
+        if (cumulated >= rank) {
+            return 1UL << bucket;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Prints the statistics of every subsystem on the serial port, then resets them.
+ * @details One line per subsystem: name, number of measures, min / mean / max (µs), 50th and 99th percentiles and the histogram buckets.
+ *          The current mode is printed first since it sets the LED and buzzer load. The input to actuation latency is checked against PROFILE_LATENCY_LIMIT.
+ */
+void profileDump() {
+    Serial.print("Mode ");
+    Serial.println(mode);
+
+    for (uint8_t id = 0; id < PROFILE_COUNT; id++) {
+        profileStats_t* stats = &profileStats[id];
+
+        Serial.print(profileNames[id]);
+        Serial.print(": n=");
+        Serial.print(stats->count);
+
+        if (stats->count != 0) {
+            Serial.print(" min=");
+            Serial.print(stats->min);
+            Serial.print(" mean=");
+            Serial.print(stats->sum / stats->count);
+            Serial.print(" max=");
+            Serial.print(stats->max);
+
+            unsigned long p50 = percentileBound(stats, 50);
+            unsigned long p99 = percentileBound(stats, 99);
+
+            Serial.print(" p50<");
+            Serial.print(p50);
+            Serial.print(" p99<");
+            Serial.print(p99);
+
+            if (id == PROFILE_LATENCY) {
+                // A percentile in the last bucket has no upper bound
+                Serial.print((p99 != 0 && p99 <= PROFILE_LATENCY_LIMIT) ? " PASS" : " FAIL");
+            }
+        }
+
+        Serial.print(" us | log2 histogram:");
+        for (uint8_t bucket = 0; bucket < PROFILE_BUCKETS; bucket++) {
+            Serial.print(' ');
+            Serial.print(stats->histogram[bucket]);
+        }
+        Serial.println();
+
+        memset(stats, 0, sizeof(profileStats_t));
+    }
+}
+
+#endif
@@ -0,0 +1,113 @@
+/**
+ * @file scheduler.cpp
+ * @brief Source file containing the cooperative task scheduler implementation.
+ * @details Fixed-rate cooperative scheduler: the tasks run to completion, one per call of schedulerRun(),
+ *          in the order of their release time.
+ */
+
+//=============================================================================
+//                       INCLUDE LIBRARIES AND HEADER FILES
+//=============================================================================
+
+#include "../Inc/scheduler.h"
+
+#include <avr/sleep.h>
+
+//=============================================================================
+//                             ROUTINE DEFINITIONS
+//=============================================================================
+
+/**
+ * @brief Schedules the first run of every task of the table.
+ * @param tasks Static task table.
+ * @param count Number of tasks in the table.
+ */
+void schedulerBegin(task_t* tasks, uint8_t count) {
+    unsigned long now = micros();
+
+    for (uint8_t i = 0; i < count; i++) {
+        tasks[i].nextRun = now;
+        tasks[i].maxDuration = 0;
+        tasks[i].budgetOverruns = 0;
+        tasks[i].missedPeriods = 0;
+    }
+
+    set_sleep_mode(SLEEP_MODE_IDLE);
+}
+
+/**
+ * @brief Runs the most overdue ready task of the table.
+ * @param tasks Static task table.
+ * @param count Number of tasks in the table.
+ * @return True if a task was run, false if no task is ready and the CPU can do background work or idle.
+ * @details Only one task is run per call, always the one with the earliest release time, so that a task can't starve the others.
+ *          A task late by more than one period is rescheduled from now instead of running several times in a row.
+ */
+bool schedulerRun(task_t* tasks, uint8_t count) {
+    unsigned long now = micros();
+
+    // Find the ready task that has been waiting the longest
+    task_t* next = NULL;
+    unsigned long longestLateness = 0;
+
+    for (uint8_t i = 0; i < count; i++) {
+        unsigned long lateness = now - tasks[i].nextRun;
+
+        // Wrap-safe test of nextRun <= now
+        if ((long)lateness >= 0 && (next == NULL || lateness > longestLateness)) {
+            next = &tasks[i];
+            longestLateness = lateness;
+        }
+    }
+
+    if (next == NULL) {
+        return false;
+    }
+
+    if (longestLateness >= next->period) {
+        next->missedPeriods++;
+        next->nextRun = now + next->period;
+    } else {
+        next->nextRun += next->period;
+    }
+
+    unsigned long start = micros();
+    next->run();
+    unsigned long duration = micros() - start;
+
+    if (duration > next->maxDuration) {
+        next->maxDuration = duration;
+    }
+
+    if (duration > next->budget) {
+        next->budgetOverruns++;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Idles the CPU until the next interrupt (at most about 1 ms with the millis() timer).
+ */
+void schedulerIdle() {
+    sleep_mode();
+}
+
+/**
+ * @brief Prints the statistics of every task on the serial port.
+ * @param tasks Static task table.
+ * @param count Number of tasks in the table.
+ */
+void schedulerPrintStats(const task_t* tasks, uint8_t count) {
+    for (uint8_t i = 0; i < count; i++) {
+        Serial.print(tasks[i].name);
+        Serial.print(": max ");
+        Serial.print(tasks[i].maxDuration);
+        Serial.print(" us / budget ");
+        Serial.print(tasks[i].budget);
+        Serial.print(" us, overruns ");
+        Serial.print(tasks[i].budgetOverruns);
+        Serial.print(", missed periods ");
+        Serial.println(tasks[i].missedPeriods);
+    }
+}
@@ -6,37 +6,84 @@
 * the definition of LED display patterns and the routines to update the LED display.
 */
 
-#pragma once
-
 //=============================================================================
 //                       INCLUDE LIBRARIES AND HEADER FILES
 //=============================================================================
 
 #include "../Inc/strip_led.h"
 
+#include "../Inc/profiler.h"
+
+#include "../Inc/buzzer.h"
+
 //=============================================================================
 //                             VARIABLE DEFINITIONS
 //=============================================================================
 
 /**
-* @brief RGB color values for default pattern.
+* @brief RGB color values for default pattern, stored in flash.
+*/
+static const uint8_t RGB_values1[][3] PROGMEM = { { 30, 2, 50 }, { 0, 0, 100 }, { 0, 50, 50 }, { 69, 6, 23 } };
+
+/**
+* @brief RGB color values for Italy pattern, stored in flash.
+*/
+static const uint8_t RGB_values2[][3] PROGMEM = { { 100, 0, 0 }, { 0, 100, 0 }, { 50, 50, 50 } };
+
+/**
+* @brief RGB color values for France pattern, stored in flash.
 */
-const uint RGB_values1[n_LED1][3] = { { 30, 2, 50 }, { 0, 0, 100 }, { 0, 50, 50 }, { 69, 6, 23 } }; 
+static const uint8_t RGB_values3[][3] PROGMEM = { { 100, 0, 0 }, { 50, 50, 50 }, { 0, 0, 100 } };
 
 /**
-* @brief RGB color values for Italy pattern.
+* @brief RGB color values for rainbow pattern, stored in flash.
 */
-const uint RGB_values2[n_LED2][3] = { { 100, 0, 0 }, { 0, 100, 0 }, { 50, 50, 50 } }; 
+static const uint8_t RGB_values4[][3] PROGMEM = { { 30, 2, 50 }, { 0, 0, 100 }, { 5, 50, 30 }, { 0, 100, 0 }, { 50, 40, 0 }, { 75, 15, 0 }, { 100, 0, 0 } };
 
 /**
-* @brief RGB color values for France pattern.
+* @brief Registry of the LED patterns, indexed by mode, stored in flash.
+* @details Adding a pattern only takes a palette and an entry here, which also adds a mode and selects the music played in it.
 */
-const uint RGB_values3[n_LED3][3] = { { 100, 0, 0 }, { 50, 50, 50 }, { 0, 0, 100 } }; 
+constexpr ledPattern_t ledPatterns[] PROGMEM = {
+  LED_PATTERN(RGB_values1, 0, SONG_PINK_PANTHER, "Default static"),
+  LED_PATTERN(RGB_values2, 0, SONG_NOKIA, "Italy static"),
+  LED_PATTERN(RGB_values3, 0, SONG_SUBWAY_SURFERS, "France static"),
+  LED_PATTERN(RGB_values4, 0, SONG_THE_SIMPSONS, "Rainbow static"),
+  LED_PATTERN(RGB_values1, LED_DYNAMIC_PERIOD, SONG_PINK_PANTHER, "Default dynamic"),
+  LED_PATTERN(RGB_values2, LED_DYNAMIC_PERIOD, SONG_NOKIA, "Italy dynamic"),
+  LED_PATTERN(RGB_values3, LED_DYNAMIC_PERIOD, SONG_SUBWAY_SURFERS, "France dynamic"),
+  LED_PATTERN(RGB_values4, LED_DYNAMIC_PERIOD, SONG_THE_SIMPSONS, "Rainbow dynamic"),
+  { NULL, 0, 0, NO_SONG, "Rainbow dynamic and faded" }   // Generated by renderRainbow()
+};
 
 /**
-* @brief RGB color values for rainbow pattern.
+* @brief Number of entries of the pattern registry, i.e. of modes.
 */
-const uint RGB_values4[n_LED4][3] = { { 30, 2, 50 }, { 0, 0, 100 }, { 5, 50, 30 }, { 0, 100, 0 }, { 50, 40, 0 }, { 75, 15, 0 }, { 100, 0, 0 } }; 
+const uint8_t ledPatternCount = sizeof(ledPatterns) / sizeof(ledPattern_t);
+
+static_assert(sizeof(ledPatterns) / sizeof(ledPattern_t) <= UINT8_MAX, "Too many LED patterns");
+
+/**
+* @brief Gamma correction table (gamma 2.6), from linear 8-bit intensities to LED PWM values, stored in flash.
+*/
+const uint8_t gamma8[256] PROGMEM = {
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,   0,   0,   0,   0,   0,   1,   1,   1,   1,   1,   1,   1,   1,
+    1,   1,   1,   1,   2,   2,   2,   2,   2,   2,   2,   2,   3,   3,   3,   3,
+    3,   3,   4,   4,   4,   4,   5,   5,   5,   5,   5,   6,   6,   6,   6,   7,
+    7,   7,   8,   8,   8,   9,   9,   9,  10,  10,  10,  11,  11,  11,  12,  12,
+   13,  13,  13,  14,  14,  15,  15,  16,  16,  17,  17,  18,  18,  19,  19,  20,
+   20,  21,  21,  22,  22,  23,  24,  24,  25,  25,  26,  27,  27,  28,  29,  29,
+   30,  31,  31,  32,  33,  34,  34,  35,  36,  37,  38,  38,  39,  40,  41,  42,
+   42,  43,  44,  45,  46,  47,  48,  49,  50,  51,  52,  53,  54,  55,  56,  57,
+   58,  59,  60,  61,  62,  63,  64,  65,  66,  68,  69,  70,  71,  72,  73,  75,
+   76,  77,  78,  80,  81,  82,  84,  85,  86,  88,  89,  90,  92,  93,  94,  96,
+   97,  99, 100, 102, 103, 105, 106, 108, 109, 111, 112, 114, 115, 117, 119, 120,
+  122, 124, 125, 127, 129, 130, 132, 134, 136, 137, 139, 141, 143, 145, 146, 148,
+  150, 152, 154, 156, 158, 160, 162, 164, 166, 168, 170, 172, 174, 176, 178, 180,
+  182, 184, 186, 188, 191, 193, 195, 197, 199, 202, 204, 206, 209, 211, 213, 215,
+  218, 220, 223, 225, 227, 230, 232, 235, 237, 240, 242, 245, 247, 250, 252, 255
+};
 
 /**
 * @brief Current operating mode for LED and buzzer.
@@ -49,7 +96,8 @@ const uint RGB_values4[n_LED4][3] = { { 30, 2, 50 }, { 0, 0, 100 }, { 5, 50, 30
 *   - 5: Italy dynamic, Nokia ringtone
 *   - 6: France dynamic, Subway Surfers theme
 *   - 7: Rainbow dynamic, The Simpsons theme
-*   - 8: LED off
+*   - 8: Rainbow dynamic and faded, no music
+*   There is one mode per entry of ledPatterns.
 *  
 */
 int mode = 0;
@@ -57,130 +105,305 @@ int mode = 0;
 /**
 * @brief NeoPixel strip controller instance.
 */
-Adafruit_NeoPixel pixels(NUM_PIXELS, PIN_NEOPIXEL, NEO_GRB + NEO_KHZ800); 
+stripDriver_t pixels(NUM_PIXELS, PIN_NEOPIXEL, NEO_GRB + NEO_KHZ800);
+
+/**
+* @brief Number of frames sent to the LED strip.
+*/
+unsigned long ledFramesPushed = 0;
+
+/**
+* @brief Number of frames skipped because they were identical to the last frame sent.
+*/
+unsigned long ledFramesSkipped = 0;
+
+
+//=============================================================================
+//                              CLASS DEFINITIONS
+//=============================================================================
+
+/**
+ * @brief Sends the pixel colors to the strip, one segment at a time.
+ * @details The library routine sends the whole buffer it is given with the interrupts disabled, then enables them again:
+ *          it is pointed at each segment in turn. Its wait for the strip reset time is skipped between the segments of a frame,
+ *          but kept before the first one so that the previous frame is latched.
+ */
+void ChunkedNeoPixel::show() {
+  uint8_t* frame = pixels;
+  uint16_t frameBytes = numBytes;
+
+  if (frame == NULL) {
+      return;
+  }
 
+  // 3 bytes per pixel (NEO_GRB)
+  for (uint16_t sent = 0; sent < frameBytes; sent += STRIP_CHUNK_PIXELS * 3) {
+      pixels = frame + sent;
+      numBytes = min(frameBytes - sent, STRIP_CHUNK_PIXELS * 3);
+
+      Adafruit_NeoPixel::show();
+
+      // Pretend the last frame ended long ago so that the next segment is sent right away
+      endTime = 0;
+  }
+
+  pixels = frame;
+  numBytes = frameBytes;
+  endTime = micros();
+}
 
 //=============================================================================
 //                             ROUTINE DEFINITIONS
 //=============================================================================
 
+/**
+ * @brief Sets the color of every pixel of the strip from a pattern stored in flash.
+ * @param pattern RGB color values of the pattern, stored in flash.
+ * @param size Number of LED in the pattern.
+ * @param offset Index of the pattern color of the first pixel.
+ * @details The pattern index wraps around instead of being computed with a modulo, which is a software division on AVR.
+ */
+static void renderPattern(const uint8_t (*pattern)[3], uint8_t size, uint8_t offset) {
+  uint8_t index = offset;
+
+  for (uint8_t i = 0; i < NUM_PIXELS; i++) {
+      pixels.setPixelColor(i, pgm_read_byte(&pattern[index][0]),
+                              pgm_read_byte(&pattern[index][1]),
+                              pgm_read_byte(&pattern[index][2]));
+
+      if (++index == size) {
+          index = 0;
+      }
+  }
+}
+
+/**
+ * @brief Converts a fully saturated hue to an RGB color, with integer arithmetic only.
+ * @param hue Hue on 8 bits, 256 is a full turn of the color wheel.
+ * @param red Pointer to the red intensity to set, in [0; 255].
+ * @param green Pointer to the green intensity to set, in [0; 255].
+ * @param blue Pointer to the blue intensity to set, in [0; 255].
+ * @details The color wheel is split into 6 sectors in which one channel ramps up or down while the others are constant.
+ */
+static void hueToRgb(uint8_t hue, uint8_t* red, uint8_t* green, uint8_t* blue) {
+  uint16_t position = hue * 6;
+  uint8_t sector = position >> 8;
+  uint8_t rising = position & 0xFF;
+  uint8_t falling = 255 - rising;
+
+  switch (sector) {
+    case 0:  *red = 255;     *green = rising;  *blue = 0;       break;
+    case 1:  *red = falling; *green = 255;     *blue = 0;       break;
+    case 2:  *red = 0;       *green = 255;     *blue = rising;  break;
+    case 3:  *red = 0;       *green = falling; *blue = 255;     break;
+    case 4:  *red = rising;  *green = 0;       *blue = 255;     break;
+    default: *red = 255;     *green = 0;       *blue = falling; break;
+  }
+}
+
+/**
+ * @brief Sets the color of every pixel of the strip to a rotating and breathing rainbow.
+ * @param elapsed Time elapsed since the previous frame (ms).
+ * @details The hue of the first pixel and the fade level come from phase accumulators advanced by the elapsed time,
+ * so the animation speed does not depend on the frame rate. Each pixel is RAINBOW_HUE_SPACING further on the color wheel.
+ * The channels are gamma corrected and scaled by the fade level, without any division.
+ */
+static void renderRainbow(unsigned long elapsed) {
+  // Phase accumulators, in 1/256 of hue and fade unit
+  static uint16_t huePhase = 0;
+  static uint16_t fadePhase = 0;
+
+  huePhase += elapsed * RAINBOW_HUE_SPEED;
+  fadePhase += elapsed * RAINBOW_FADE_SPEED;
+
+  // Triangle wave between RAINBOW_MIN_FADE and 255, then perceptual level in [0; RAINBOW_MAX_LEVEL]
+  uint8_t triangle = fadePhase >> 8;
+  triangle = (triangle < 128) ? triangle << 1 : (255 - triangle) << 1;
+  uint8_t fade = RAINBOW_MIN_FADE + ((triangle * (uint16_t)(255 - RAINBOW_MIN_FADE)) >> 8);
+  uint16_t level = ((pgm_read_byte(&gamma8[fade]) * (uint16_t)RAINBOW_MAX_LEVEL) >> 8) + 1;
+
+  uint8_t hue = huePhase >> 8;
+
+  for (uint8_t i = 0; i < NUM_PIXELS; i++) {
+      uint8_t red, green, blue;
+      hueToRgb(hue, &red, &green, &blue);
+
+      pixels.setPixelColor(i, (pgm_read_byte(&gamma8[red]) * level) >> 8,
+                              (pgm_read_byte(&gamma8[green]) * level) >> 8,
+                              (pgm_read_byte(&gamma8[blue]) * level) >> 8);
+
+      hue += RAINBOW_HUE_SPACING;
+  }
+}
+
+/**
+ * @brief Sets the color of every pixel of the strip for a mode, without sending them to the strip.
+ * @param mode Display mode, in [0; ledPatternCount[.
+ * @param offset Index of the palette color of the first pixel, ignored by the rainbow.
+ * @param elapsed Time elapsed since the previous frame (ms), only used by the rainbow.
+ */
+void renderLED_Frame(int mode, uint8_t offset, unsigned long elapsed) {
+  const ledPattern_t* pattern = &ledPatterns[mode];
+  const uint8_t (*palette)[3] = (const uint8_t (*)[3])pgm_read_ptr(&pattern->palette);
+
+  if (palette == NULL) {
+      renderRainbow(elapsed);
+  } else {
+      renderPattern(palette, pgm_read_byte(&pattern->length), offset);
+  }
+}
+
 /**
  * @brief Updates the LED display based on the current mode.
  * 
  * This function handles the logic for updating the LED display. 
- * It clears the NeoPixel strip, applies timing control for dynamic modes, and then sets the
- * pixel colors based on the current display mode. 
- * The procedure supports four different patterns: default, Italy, France, and rainbow. 
- * It also handles both static and dynamic modes.
+ * It applies timing control for dynamic modes, and then, if the frame changed, clears the NeoPixel strip,
+ * sets the pixel colors based on the current display mode and sends them to the strip.
+ * The pattern of the current mode is read from the ledPatterns registry: a palette shifted every period (static if 0),
+ * or the generated rainbow, which is animated every frame.
+ * A frame is only computed and sent when the mode, the pattern offset or the brightness changed,
+ * since sending it disables the interrupts for about 2 ms.
  */
 void updateLED_Display() {
 
   // Pattern control variable that controls the offset of the LED display pattern.
-  static int offset = 0;
-  
-  pixels.clear();
+  static uint8_t offset = 0;
+  static unsigned long lastShift = 0;
+
+  // Parameters of the last frame sent to the strip.
+  static int lastMode = -1;
+  static uint8_t lastOffset = 0;
+  static uint8_t lastBrightness = 0;
+  static unsigned long lastFrameTime = 0;
+
+  unsigned long currentFrameTime = millis();
+  unsigned long elapsed = currentFrameTime - lastFrameTime;
+  lastFrameTime = currentFrameTime;
   
-  // For dynamic modes (4-7), add timing control
-  if (mode >= 4 && mode <= 7) {
-      static unsigned long lastUpdate = 0;
-      unsigned long currentTime = millis();
+  if (mode < 0 || mode >= ledPatternCount) {
+      return;
+  }
       
-      if (currentTime - lastUpdate >= 100) {
-          lastUpdate = currentTime;
-          offset = (offset + 1) % getPatternSize(mode);
+  const ledPattern_t* pattern = &ledPatterns[mode];
+  const uint8_t (*palette)[3] = (const uint8_t (*)[3])pgm_read_ptr(&pattern->palette);
+  uint8_t length = pgm_read_byte(&pattern->length);
+  uint16_t period = pgm_read_word(&pattern->period);
+
+  // Restart the pattern from its first color on a mode change, the offset may not fit the new palette
+  if (mode != lastMode) {
+      offset = 0;
+      lastShift = currentFrameTime;
+  } else if (period != 0 && currentFrameTime - lastShift >= period) {
+      lastShift = currentFrameTime;
+      if (++offset >= length) {
+          offset = 0;
       }
-  } else {
-      offset = 0;  // Reset offset for static modes
   }
-  
-  if (mode!=8){
-
-    // Use the same pattern logic for both static and dynamic modes
-    int patternMode = mode % 4;  // Maps modes 4-7 to their static counterparts 0-3
-    
-    switch (patternMode) {
-      case 0:  // Default pattern (modes 0 and 4)
-          for (int i = 0; i < NUM_PIXELS; i++) {
-              pixels.setPixelColor(i, pixels.Color(RGB_values1[(offset + i) % n_LED1][0], 
-                                                 RGB_values1[(offset + i) % n_LED1][1], 
-                                                 RGB_values1[(offset + i) % n_LED1][2]));
-          }
-          break;
-          
-      case 1:  // Italy pattern (modes 1 and 5)
-          for (int i = 0; i < NUM_PIXELS; i++) {
-              pixels.setPixelColor(i, pixels.Color(RGB_values2[(offset + i) % n_LED2][0], 
-                                                 RGB_values2[(offset + i) % n_LED2][1], 
-                                                 RGB_values2[(offset + i) % n_LED2][2]));
-          }
-          break;
-          
-          case 2:  // France pattern (modes 2 and 6)
-          for (int i = 0; i < NUM_PIXELS; i++) {
-              pixels.setPixelColor(i, pixels.Color(RGB_values3[(offset + i) % n_LED3][0], 
-                                                 RGB_values3[(offset + i) % n_LED3][1], 
-                                                 RGB_values3[(offset + i) % n_LED3][2]));
-          }
-          break;
-          
-      case 3:  // Rainbow pattern (modes 3 and 7)
-          for (int i = 0; i < NUM_PIXELS; i++) {
-              pixels.setPixelColor(i, pixels.Color(RGB_values4[(offset + i) % n_LED4][0], 
-                                                 RGB_values4[(offset + i) % n_LED4][1], 
-                                                 RGB_values4[(offset + i) % n_LED4][2]));
-          }
-          break;
-    }
+
+  uint8_t brightness = pixels.getBrightness();
+
+  // Nothing changed since the last frame: skip both the computation and the transmission
+  if (palette != NULL && mode == lastMode && offset == lastOffset && brightness == lastBrightness) {
+      ledFramesSkipped++;
+      return;
   }
+
+  lastMode = mode;
+  lastOffset = offset;
+  lastBrightness = brightness;
+
+  renderLED_Frame(mode, offset, elapsed);
   
+  PROFILE_START(PROFILE_LED_SHOW);
   pixels.show();
+  PROFILE_STOP(PROFILE_LED_SHOW);
+
+  ledFramesPushed++;
 }
 
 
 /**
- * @brief Retrieves the size of the LED pattern based on the current display mode.
- * @param mode The current display mode number.
- * @return The size of the LED pattern for the given mode.
- */
-int getPatternSize(int mode) {
-  switch (mode % 4) {
-      case 0: return n_LED1;
-      case 1: return n_LED2;
-      case 2: return n_LED3;
-      case 3: return n_LED4;
-      default: return n_LED1;
+* @brief Retrieves the name of the current pattern.
+* @param mode Current display mode number.
+* @return Name of the active pattern, stored in flash.
+*/
+const __FlashStringHelper* getPatternName(int mode) {
+  if (mode < 0 || mode >= ledPatternCount) {
+      return F("Unknown");
   }
-}
 
+  return (const __FlashStringHelper*)ledPatterns[mode].name;
+}
 
 /**
-* @brief Retrieves the name of the current pattern.
-* @param mode Current display mode number.
-* @return Name of the active pattern.
+* @brief Prints the number of frames sent to the strip and skipped since startup on the serial port.
 */
-char* getPatternName(int mode) {
-  switch (mode) {
-    case 0:
-        return "Default static";
-    case 1:
-        return "Italy static";
-    case 2:
-        return "France static";
-    case 3:
-        return "Rainbow static";
-    case 4:
-        return "Default dynamic";
-    case 5:
-        return "Italy dynamic";
-    case 6:
-        return "France dynamic";
-    case 7:
-        return "Rainbow dynamic";
-    case 8:
-        return "Rainbow dynamic and faded";
-    case 9:
-        return " LED strip off";
-    default:
-        return "Unknown";
+void LED_printStats() {
+  unsigned long frames = ledFramesPushed + ledFramesSkipped;
+
+  Serial.print("LED frames: pushed ");
+  Serial.print(ledFramesPushed);
+  Serial.print(", skipped ");
+  Serial.print(ledFramesSkipped);
+  Serial.print(" (");
+  Serial.print(frames != 0 ? ledFramesSkipped * 100 / frames : 0);
+  Serial.println(" %)");
+}
+
+#ifdef BENCHMARK_STRIP_LED
+
+/**
+ * @brief Sets the color of every pixel of the strip the way it was done before the patterns moved to flash.
+ * @param pattern RGB color values of the pattern, 16-bit values in SRAM.
+ * @param size Number of LED in the pattern.
+ * @param offset Index of the pattern color of the first pixel.
+ * @details Only used as a reference by benchmarkLED_Display().
+ */
+static void renderPatternModulo(const uint pattern[][3], int size, int offset) {
+  for (int i = 0; i < NUM_PIXELS; i++) {
+      pixels.setPixelColor(i, pixels.Color(pattern[(offset + i) % size][0],
+                                         pattern[(offset + i) % size][1],
+                                         pattern[(offset + i) % size][2]));
+  }
+}
+
+/**
+ * @brief Measures the cycles spent computing one frame with the modulo render path and with the wrapping render path.
+ * @details The results are printed on the serial port for the modes 0 to 7. Nothing is sent to the strip.
+ */
+void benchmarkLED_Display() {
+  // 16-bit SRAM copy of the largest pattern, as the tables used to be
+  uint legacyPattern[sizeof(RGB_values4) / sizeof(RGB_values4[0])][3];
+
+  for (int benchMode = 0; benchMode < 8; benchMode++) {
+      const uint8_t (*palette)[3] = (const uint8_t (*)[3])pgm_read_ptr(&ledPatterns[benchMode].palette);
+      int size = pgm_read_byte(&ledPatterns[benchMode].length);
+      int offset = (pgm_read_word(&ledPatterns[benchMode].period) != 0) ? size - 1 : 0;
+
+      for (int i = 0; i < size; i++) {
+          for (int channel = 0; channel < 3; channel++) {
+              legacyPattern[i][channel] = pgm_read_byte(&palette[i][channel]);
+          }
+      }
+
+      startCycleCounter();
+      renderPatternModulo(legacyPattern, size, offset);
+      uint32_t moduloCycles = readCycleCounter();
+
+      startCycleCounter();
+      renderPattern(palette, size, offset);
+      uint32_t wrappingCycles = readCycleCounter();
+
+      Serial.print("LED mode ");
+      Serial.print(benchMode);
+      Serial.print(": modulo ");
+      Serial.print(moduloCycles);
+      Serial.print(" cycles, wrapping ");
+      Serial.print(wrappingCycles);
+      Serial.println(" cycles");
   }
-}
\ No newline at end of file
+
+  pixels.clear();
+}
+
+#endif
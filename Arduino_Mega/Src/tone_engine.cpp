@@ -0,0 +1,198 @@
+/**
+ * @file tone_engine.cpp
+ * @brief Source file containing the timer-interrupt tone engine implementation.
+ * @details The Timer1 compare match ISR toggles the buzzer pin and consumes the note segments queued by the main loop.
+ *          The queue is a single-producer single-consumer ring buffer: the head is only written by the main loop and the
+ *          tail only by the ISR, so no lock is needed on the 8-bit AVR.
+ */
+
+//=============================================================================
+//                       INCLUDE LIBRARIES AND HEADER FILES
+//=============================================================================
+
+#include "../Inc/tone_engine.h"
+
+#include "../Inc/buzzer.h"
+
+//=============================================================================
+//                                   MACROS
+//=============================================================================
+
+/**
+ * @brief Builds the pitch table entry of the given frequency.
+ */
+#define PITCH(frequency) { (frequency), TONE_COMPARE(frequency), TONE_TOGGLES_PER_MS(frequency) }
+
+//=============================================================================
+//                             VARIABLE DEFINITIONS
+//=============================================================================
+
+/**
+ * @brief Precomputed timer values for every pitch of pitches.h, indexed by pitchIndex_t and stored in flash.
+ * @note The entries must stay in the order of pitchIndex_t.
+ */
+const pitch_t pitch_tab[PITCH_COUNT] PROGMEM = {
+    { REST, SILENCE_COMPARE, 0 },
+    PITCH(NOTE_B0), PITCH(NOTE_C1), PITCH(NOTE_CS1), PITCH(NOTE_D1), PITCH(NOTE_DS1), PITCH(NOTE_E1),
+    PITCH(NOTE_F1), PITCH(NOTE_FS1), PITCH(NOTE_G1), PITCH(NOTE_GS1), PITCH(NOTE_A1), PITCH(NOTE_AS1),
+    PITCH(NOTE_B1), PITCH(NOTE_C2), PITCH(NOTE_CS2), PITCH(NOTE_D2), PITCH(NOTE_DS2), PITCH(NOTE_E2),
+    PITCH(NOTE_F2), PITCH(NOTE_FS2), PITCH(NOTE_G2), PITCH(NOTE_GS2), PITCH(NOTE_A2), PITCH(NOTE_AS2),
+    PITCH(NOTE_B2), PITCH(NOTE_C3), PITCH(NOTE_CS3), PITCH(NOTE_D3), PITCH(NOTE_DS3), PITCH(NOTE_E3),
+    PITCH(NOTE_F3), PITCH(NOTE_FS3), PITCH(NOTE_G3), PITCH(NOTE_GS3), PITCH(NOTE_A3), PITCH(NOTE_AS3),
+    PITCH(NOTE_B3), PITCH(NOTE_C4), PITCH(NOTE_CS4), PITCH(NOTE_D4), PITCH(NOTE_DS4), PITCH(NOTE_E4),
+    PITCH(NOTE_F4), PITCH(NOTE_FS4), PITCH(NOTE_G4), PITCH(NOTE_GS4), PITCH(NOTE_A4), PITCH(NOTE_AS4),
+    PITCH(NOTE_B4), PITCH(NOTE_C5), PITCH(NOTE_CS5), PITCH(NOTE_D5), PITCH(NOTE_DS5), PITCH(NOTE_E5),
+    PITCH(NOTE_F5), PITCH(NOTE_FS5), PITCH(NOTE_G5), PITCH(NOTE_GS5), PITCH(NOTE_A5), PITCH(NOTE_AS5),
+    PITCH(NOTE_B5), PITCH(NOTE_C6), PITCH(NOTE_CS6), PITCH(NOTE_D6), PITCH(NOTE_DS6), PITCH(NOTE_E6),
+    PITCH(NOTE_F6), PITCH(NOTE_FS6), PITCH(NOTE_G6), PITCH(NOTE_GS6), PITCH(NOTE_A6), PITCH(NOTE_AS6),
+    PITCH(NOTE_B6), PITCH(NOTE_C7), PITCH(NOTE_CS7), PITCH(NOTE_D7), PITCH(NOTE_DS7), PITCH(NOTE_E7),
+    PITCH(NOTE_F7), PITCH(NOTE_FS7), PITCH(NOTE_G7), PITCH(NOTE_GS7), PITCH(NOTE_A7), PITCH(NOTE_AS7),
+    PITCH(NOTE_B7), PITCH(NOTE_C8), PITCH(NOTE_CS8), PITCH(NOTE_D8), PITCH(NOTE_DS8)
+};
+
+/**
+ * @brief Ring buffer of the segments waiting to be played.
+ */
+static toneSegment_t toneQueue[TONE_QUEUE_SIZE];
+
+/**
+ * @brief Index of the next free slot. Only written by the main loop.
+ */
+static volatile uint8_t toneQueueHead = 0;
+
+/**
+ * @brief Index of the next segment to play. Only written by the ISR.
+ */
+static volatile uint8_t toneQueueTail = 0;
+
+/**
+ * @brief Number of interrupts left in the segment being played. Only used by the ISR.
+ */
+static uint16_t remainingTicks = 0;
+
+/**
+ * @brief True if the segment being played toggles the buzzer pin. Only used by the ISR.
+ */
+static bool sounding = false;
+
+//=============================================================================
+//                             ROUTINE DEFINITIONS
+//=============================================================================
+
+/**
+ * @brief Adds a segment to the queue and starts the timer interrupt if the engine was idle.
+ * @param compare Timer1 compare value used during the segment.
+ * @param ticks Number of compare match interrupts the segment lasts.
+ * @param isSounding True if the buzzer pin must be toggled during the segment.
+ */
+static void pushSegment(uint16_t compare, uint16_t ticks, bool isSounding) {
+    uint8_t head = toneQueueHead;
+
+    toneQueue[head].compare = compare;
+    toneQueue[head].ticks = ticks;
+    toneQueue[head].sounding = isSounding;
+
+    // Publish the segment only once it is completely written
+    toneQueueHead = (head + 1) & (TONE_QUEUE_SIZE - 1);
+
+    if (!(TIMSK1 & _BV(OCIE1A))) {
+        // Fire the interrupt on the next timer tick so that it loads the segment
+        OCR1A = 1;
+        TCNT1 = 0;
+        TIMSK1 |= _BV(OCIE1A);
+    }
+}
+
+/**
+ * @brief Configures Timer1 for the tone engine. The timer interrupt stays disabled until a segment is queued.
+ */
+void toneEngineBegin() {
+    TIMSK1 = 0;
+    TCCR1A = 0;
+
+    // CTC mode (TOP = OCR1A), prescaler 8
+    TCCR1B = _BV(WGM12) | _BV(CS11);
+    OCR1A = SILENCE_COMPARE;
+
+    BUZZER_PORT &= ~_BV(BUZZER_BIT);
+}
+
+/**
+ * @brief Stops the sound immediately and empties the queue.
+ */
+void toneEngineStop() {
+    TIMSK1 &= ~_BV(OCIE1A);
+
+    toneQueueHead = 0;
+    toneQueueTail = 0;
+    remainingTicks = 0;
+    sounding = false;
+
+    BUZZER_PORT &= ~_BV(BUZZER_BIT);
+}
+
+/**
+ * @brief Queues a note followed by the silence distinguishing it from the next one.
+ * @param pitch Index of the note in pitch_tab, PITCH_REST for a silent note.
+ * @param duration Duration of the note (ms).
+ * @param gap Duration of the silence after the note (ms).
+ * @return True if the note was queued, false if the queue is full.
+ */
+bool toneEnginePushNote(uint8_t pitch, uint16_t duration, uint16_t gap) {
+    if (toneEngineFreeSlots() < 2 || pitch >= PITCH_COUNT) {
+        return false;
+    }
+
+    if (pitch != PITCH_REST) {
+        uint16_t compare = pgm_read_word(&pitch_tab[pitch].compare);
+        uint16_t togglesPerMs = pgm_read_word(&pitch_tab[pitch].togglesPerMs);
+        pushSegment(compare, ((uint32_t)duration * togglesPerMs) >> 8, true);
+    } else {
+        pushSegment(SILENCE_COMPARE, duration, false);
+    }
+
+    pushSegment(SILENCE_COMPARE, gap, false);
+
+    return true;
+}
+
+/**
+ * @brief Gets the number of free segments in the queue.
+ * @return Number of segments that can still be queued.
+ */
+uint8_t toneEngineFreeSlots() {
+    // One slot is kept empty to distinguish a full queue from an empty one
+    return (toneQueueTail - toneQueueHead - 1) & (TONE_QUEUE_SIZE - 1);
+}
+
+/**
+ * @brief Timer1 compare match interrupt: plays the current segment and loads the next one when it is over.
+ */
+ISR(TIMER1_COMPA_vect) {
+    while (remainingTicks == 0) {
+        uint8_t tail = toneQueueTail;
+
+        if (tail == toneQueueHead) {
+            // Nothing left to play: silence the buzzer and stop the interrupt
+            TIMSK1 &= ~_BV(OCIE1A);
+            BUZZER_PORT &= ~_BV(BUZZER_BIT);
+            sounding = false;
+            return;
+        }
+
+        OCR1A = toneQueue[tail].compare;
+        remainingTicks = toneQueue[tail].ticks;
+        sounding = toneQueue[tail].sounding;
+        toneQueueTail = (tail + 1) & (TONE_QUEUE_SIZE - 1);
+
+        if (!sounding) {
+            BUZZER_PORT &= ~_BV(BUZZER_BIT);
+        }
+    }
+
+    if (sounding) {
+        BUZZER_PIN_REG = _BV(BUZZER_BIT);
+    }
+
+    remainingTicks--;
+}
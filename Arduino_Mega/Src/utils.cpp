@@ -19,15 +19,20 @@
 */
 Bonezegei_Printf debug(&Serial); 
 
+/**
+* @brief Number of cycle counter overflows since startCycleCounter(), i.e. the upper 16 bits of the cycle count.
+*/
+static volatile uint16_t cycleCounterOverflows = 0;
+
 //=============================================================================
 //                              ROUTINE DEFINITIONS
 //=============================================================================
 
 /**
-* @brief Increments the current LED and buzzer mode. Mode values range from 0 to 8.
+* @brief Increments the current LED and buzzer mode. Mode values range from 0 to ledPatternCount - 1.
 */
 void updateMode() {
-    mode = (mode > 7) ? 0 : mode + 1;
+    mode = (mode + 1 >= ledPatternCount) ? 0 : mode + 1;
 }
 
 /**
@@ -46,3 +51,45 @@ uint8_t intToUint8_t(int i) {
         }
     }
 }
+
+/**
+* @brief Resets and starts the cycle counter (Timer5, no prescaler).
+* @note Timer5 is dedicated to the cycle counter, its PWM pins (44 to 46) must not be used.
+*/
+void startCycleCounter() {
+    TCCR5B = 0;
+    TCCR5A = 0;
+    TCNT5 = 0;
+    cycleCounterOverflows = 0;
+    TIFR5 = _BV(TOV5);
+    TIMSK5 = _BV(TOIE5);
+    TCCR5B = _BV(CS50);
+}
+
+/**
+* @brief Reads the number of CPU cycles elapsed since startCycleCounter().
+* @return Number of elapsed CPU cycles.
+*/
+uint32_t readCycleCounter() {
+    uint8_t oldSREG = SREG;
+    cli();
+
+    uint16_t low = TCNT5;
+    uint16_t high = cycleCounterOverflows;
+
+    // Overflow not handled yet by the ISR since the interrupts are disabled
+    if ((TIFR5 & _BV(TOV5)) && low < 0x8000) {
+        high++;
+    }
+
+    SREG = oldSREG;
+
+    return ((uint32_t)high << 16) | low;
+}
+
+/**
+* @brief Timer5 overflow interrupt: extends the cycle counter to 32 bits.
+*/
+ISR(TIMER5_OVF_vect) {
+    cycleCounterOverflows++;
+}
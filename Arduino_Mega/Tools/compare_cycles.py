@@ -0,0 +1,133 @@
+#!/usr/bin/env python3
+"""
+@file compare_cycles.py
+@brief Compares the cycle counts printed by the Arduino Mega (see Inc/benchmark.h) with a baseline recorded on the robot.
+@details The firmware must be built with BENCHMARK_CYCLES enabled. The "cycles <function> <case> <count>" lines are read
+         until the last expected function is reported, any other output (such as binary log records) is ignored. Each count
+         is printed with its difference to Tools/cycles_baseline.txt, and the script fails if a count exceeds its baseline
+         by more than the tolerance, or if there is no baseline yet.
+         With --update, the baseline is rewritten from the measured counts instead, so that the change shows up in review.
+         Only captures of the robot are comparable: the host simulation prints execution times of the computer instead.
+
+Usage:
+    compare_cycles.py /dev/ttyACM0              # read from a serial port (requires pyserial), reset the board to start
+    compare_cycles.py capture.txt               # read from a text capture file
+    compare_cycles.py --tolerance 2 capture.txt # accept up to 2 % more cycles than the baseline
+    compare_cycles.py --update /dev/ttyACM0     # record a new baseline
+"""
+
+import argparse
+import os
+import sys
+
+SERIAL_RATE = 38400
+
+BASELINE = os.path.join(os.path.dirname(os.path.abspath(__file__)), "cycles_baseline.txt")
+
+# Last function measured by benchmarkCycles(), its last reported case ends the capture
+LAST_FUNCTION = "buzz"
+LAST_CASE = "3"
+
+
+def read_counts(lines, stop=True):
+    """Returns the {(function, case): cycles} dictionary of the benchmark lines, up to the last case of benchmarkCycles() if stop is set."""
+    counts = {}
+
+    for line in lines:
+        fields = line.split()
+        if len(fields) != 4 or fields[0] != "cycles" or not fields[3].isdigit():
+            continue
+
+        counts[(fields[1], fields[2])] = int(fields[3])
+        if stop and (fields[1], fields[2]) == (LAST_FUNCTION, LAST_CASE):
+            break
+
+    return counts
+
+
+def serial_lines(port):
+    """Yields the text lines received on the serial port."""
+    while True:
+        yield port.readline().decode("ascii", "replace")
+
+
+def load_baseline(path=BASELINE):
+    """Returns the baseline counts, empty if no baseline was recorded yet."""
+    if not os.path.isfile(path):
+        return {}
+
+    with open(path) as baseline:
+        return read_counts(baseline, stop=False)
+
+
+def save_baseline(counts, path=BASELINE):
+    with open(path, "w") as baseline:
+        for (function, case), cycles in sorted(counts.items()):
+            baseline.write("cycles %s %s %d\n" % (function, case, cycles))
+
+
+def compare(counts, baseline, tolerance, output=sys.stdout):
+    """Prints each count with its difference to the baseline, returns the number of regressions."""
+    regressions = 0
+
+    for key in sorted(set(counts) | set(baseline)):
+        function, case = key
+        name = "%s %s" % (function, case)
+
+        if key not in counts:
+            output.write("%-45s missing\n" % name)
+            regressions += 1
+            continue
+
+        if key not in baseline:
+            output.write("%-45s %8d (new)\n" % (name, counts[key]))
+            continue
+
+        difference = counts[key] - baseline[key]
+        status = ""
+        if counts[key] > baseline[key] * (1 + tolerance / 100.0):
+            status = " REGRESSION"
+            regressions += 1
+
+        output.write("%-45s %8d %+8d%s\n" % (name, counts[key], difference, status))
+
+    return regressions
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compares the cycle counts of the firmware with the recorded baseline.")
+    parser.add_argument("source", help="serial port or capture file")
+    parser.add_argument("--tolerance", type=float, default=0.0, help="accepted increase (%%), the counts are exact by default")
+    parser.add_argument("--update", action="store_true", help="rewrite the baseline from the measured counts")
+    arguments = parser.parse_args()
+
+    if os.path.isfile(arguments.source):
+        with open(arguments.source, errors="replace") as capture:
+            counts = read_counts(capture)
+    else:
+        import serial
+        with serial.Serial(arguments.source, SERIAL_RATE) as port:
+            counts = read_counts(serial_lines(port))
+
+    if not counts:
+        sys.stderr.write("No cycle counts found, is BENCHMARK_CYCLES enabled?\n")
+        return 1
+
+    if arguments.update:
+        save_baseline(counts)
+        sys.stdout.write("Baseline of %d counts written to %s\n" % (len(counts), BASELINE))
+        return 0
+
+    baseline = load_baseline()
+    if not baseline:
+        sys.stderr.write("No baseline yet, record one with --update\n")
+        return 1
+
+    regressions = compare(counts, baseline, arguments.tolerance)
+    sys.stdout.write("%d regression(s)\n" % regressions)
+
+    return 1 if regressions else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,90 @@
+#!/usr/bin/env python3
+"""
+@file decode_log.py
+@brief Decodes the binary log records sent by the Arduino Mega (see Inc/logger.h) into text.
+@details The event formats are read from the comments of the logEvent_t enumeration of Inc/logger.h,
+         so that the decoder always matches the firmware.
+
+Usage:
+    decode_log.py /dev/ttyACM0          # read from a serial port (requires pyserial)
+    decode_log.py capture.bin           # read from a raw capture file
+"""
+
+import os
+import re
+import struct
+import sys
+
+LOG_MARKER = 0xFE
+LOG_FRAME_SIZE = 11
+SERIAL_RATE = 38400
+
+LOGGER_HEADER = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "Inc", "logger.h")
+
+
+def load_formats(path=LOGGER_HEADER):
+    """Returns the list of event formats, indexed by event id."""
+    with open(path) as header:
+        text = header.read()
+
+    enum = re.search(r"typedef enum logEvent_t \{(.*?)\}", text, re.S).group(1)
+    return [match.group(2).strip() for match in re.finditer(r"(LOG_\w+),?\s*/\*\*<(.*?)\*/", enum)]
+
+
+def decode(stream, formats, output=sys.stdout):
+    """Scans the stream for records and prints them, skipping any text or corrupted bytes."""
+    buffer = bytearray()
+
+    while True:
+        chunk = stream.read(64)
+        if not chunk:
+            return
+        buffer += chunk
+
+        while True:
+            start = buffer.find(LOG_MARKER)
+            if start < 0:
+                buffer.clear()
+                break
+            if len(buffer) - start < LOG_FRAME_SIZE:
+                del buffer[:start]
+                break
+
+            frame = buffer[start:start + LOG_FRAME_SIZE]
+            checksum = 0
+            for byte in frame[1:-1]:
+                checksum ^= byte
+
+            if checksum != frame[-1] or frame[1] >= len(formats):
+                # Not a record: resynchronize on the next marker
+                del buffer[:start + 1]
+                continue
+
+            del buffer[:start + LOG_FRAME_SIZE]
+            event, timestamp, arg0, arg1 = struct.unpack("<BIhh", bytes(frame[1:-1]))
+            message = formats[event]
+            message = message % (arg0, arg1)[:message.count("%")]
+            output.write("%10d ms: %s\n" % (timestamp, message))
+            output.flush()
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.stderr.write(__doc__)
+        return 1
+
+    formats = load_formats()
+
+    if os.path.isfile(sys.argv[1]):
+        with open(sys.argv[1], "rb") as capture:
+            decode(capture, formats)
+    else:
+        import serial
+        with serial.Serial(sys.argv[1], SERIAL_RATE) as port:
+            decode(port, formats)
+
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
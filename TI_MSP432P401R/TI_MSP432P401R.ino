@@ -9,6 +9,119 @@
 #define SERIAL_RATE 9600
 #define BT_RATE 57600
 
+// Binary protocol, must match Arduino_Mega/Inc/bluetooth.h
+// Frame: sync byte, message type, X, Y, sequence number, CRC-8 of the 4 previous bytes
+#define BT_SYNC 0xA5
+#define BT_BINARY_FRAME_SIZE 6
+#define BT_CRC8_POLYNOMIAL 0x07
+#define BT_MSG_JOYSTICK 0x01
+#define BT_MSG_MODE 0x02
+
+// Transmission timing
+#define SAMPLE_PERIOD_MS 10      // the joystick is sampled at 100 Hz
+#define SEND_DELTA 2             // minimal change of X or Y (on 8 bits) that triggers a frame
+#define KEEPALIVE_PERIOD_MS 200  // a frame is resent at least this often, even if the joystick is at rest
+#define DEBOUNCE_DELAY_MS 50     // time the select button must be stable before a press is accepted
+#define RATE_REPORT_PERIOD_MS 1000  // period of the send rate report on the serial port
+
+// Sequence number of the next frame, lets the robot detect lost frames
+uint8_t sequence = 0;
+
+// Last joystick values sent and time of the last frame
+uint8_t lastSentX = 0;
+uint8_t lastSentY = 0;
+unsigned long lastSendTime = 0;
+
+// Time of the next joystick sample
+unsigned long nextSampleTime = 0;
+
+// Debounced select button state, its last raw reading and the time of the last raw change
+int buttonState = HIGH;
+int lastButtonReading = HIGH;
+unsigned long lastDebounceTime = 0;
+
+// Number of frames sent since the last send rate report and time of that report
+unsigned int framesSent = 0;
+unsigned long lastRateReportTime = 0;
+
+// CRC-8 (polynomial 0x07, initial value 0) of the given bytes
+uint8_t crc8(const uint8_t* data, uint8_t length) {
+  uint8_t crc = 0;
+
+  while (length--) {
+    crc ^= *data++;
+
+    for (uint8_t bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x80) ? (crc << 1) ^ BT_CRC8_POLYNOMIAL : crc << 1;
+    }
+  }
+
+  return crc;
+}
+
+// Send a binary frame to the robot
+void sendFrame(uint8_t type, uint8_t x, uint8_t y) {
+  uint8_t frame[BT_BINARY_FRAME_SIZE] = { BT_SYNC, type, x, y, sequence++, 0 };
+  frame[BT_BINARY_FRAME_SIZE - 1] = crc8(frame + 1, BT_BINARY_FRAME_SIZE - 2);
+
+  Serial1.write(frame, BT_BINARY_FRAME_SIZE);
+  framesSent++;
+}
+
+// Send the joystick values if they moved by at least SEND_DELTA or if the keep-alive period elapsed
+void sendJoystick(unsigned long now) {
+
+  // read the analog value of joystick two axis
+  // Here, we need to swap X and Y because there are reversed in comparison with the axis used in the Arduino code for the joystick.
+  // Also we divide by 4 because the values received from the joystick are on 10 bits (from 0 to 1023) and we need to have them on 8 bits (from 0 to 255) to
+  // send them in a single byte each via Bluetooth.
+  // After reception, these values are likely to be multiplied by 4.
+  uint8_t x = analogRead(JOYSTICK_Y) / 4;
+  uint8_t y = analogRead(JOYSTICK_X) / 4;
+
+  bool moved = abs(x - lastSentX) >= SEND_DELTA || abs(y - lastSentY) >= SEND_DELTA;
+
+  if (moved || now - lastSendTime >= KEEPALIVE_PERIOD_MS) {
+    sendFrame(BT_MSG_JOYSTICK, x, y);
+    lastSentX = x;
+    lastSentY = y;
+    lastSendTime = now;
+  }
+}
+
+// Send a mode frame once per press of the joystick select button
+void readSelectButton(unsigned long now) {
+  int reading = digitalRead(JOYSTICK_SEL);
+
+  if (reading != lastButtonReading) {
+    lastDebounceTime = now;
+    lastButtonReading = reading;
+  }
+
+  if (now - lastDebounceTime >= DEBOUNCE_DELAY_MS && reading != buttonState) {
+    buttonState = reading;
+
+    // change mode by pressing the joystick switch
+    if (buttonState == LOW) {
+      sendFrame(BT_MSG_MODE, 0, 0);
+      lastSendTime = now;
+      Serial.write("M");
+    }
+  }
+}
+
+// Print the number of frames sent per second
+void reportSendRate(unsigned long now) {
+  if (now - lastRateReportTime >= RATE_REPORT_PERIOD_MS) {
+    Serial.print("Send rate: ");
+    Serial.print(framesSent * 1000UL / (now - lastRateReportTime));
+    Serial.println(" frames/s");
+
+    framesSent = 0;
+    lastRateReportTime = now;
+  }
+}
+
 void setup() {
 
   // initialize the pushbutton pin as an input:
@@ -18,30 +131,23 @@ void setup() {
 }
 
 void loop() {
-  int JOYSTICK_SEL_state = digitalRead(JOYSTICK_SEL);
-  if (JOYSTICK_SEL_state == HIGH) {
-    
-    // read the analog value of joystick two axis
-    int JOYSTICK_X_state = analogRead(JOYSTICK_X);
-    int JOYSTICK_Y_state = analogRead(JOYSTICK_Y);
-
-    // Bluetooth sent data 
-    // Here, we need to swap X and Y because there are reversed in comparison with the axis used in the Arduino code for the joystick.
-    // Also we divide by 4 because the values received from the joystick are on 10 bits (from 0 to 1023) and we need to have them on 8 bits (from 0 to 255) to
-    // send them in a fluid way via Bluetooth.
-    // After reception, these values are likely to be multiplied by 4.
-
-    Serial1.write("*X");
-    Serial1.print(JOYSTICK_Y_state / 4);
-    Serial1.write(",Y");
-    Serial1.print(JOYSTICK_X_state / 4);
-    Serial1.write("_");
-
-  } else {
-    // change mode by pressing the joystick switch
-    
-    Serial1.write("M");
-    Serial.write("M");
+  unsigned long now = millis();
+
+  // Sample at a fixed rate, without drifting (wrap-safe test of nextSampleTime <= now)
+  if ((long)(now - nextSampleTime) >= 0) {
+    // Restart from now instead of catching up if more than one period was missed
+    nextSampleTime = (now - nextSampleTime >= SAMPLE_PERIOD_MS) ? now + SAMPLE_PERIOD_MS : nextSampleTime + SAMPLE_PERIOD_MS;
+
+    readSelectButton(now);
+
+    if (buttonState == HIGH) {
+      sendJoystick(now);
+    } else if (now - lastSendTime >= KEEPALIVE_PERIOD_MS) {
+      // The axes move when the stick is pressed, so they are not sampled, but the link must not time out: resend the last position
+      sendFrame(BT_MSG_JOYSTICK, lastSentX, lastSentY);
+      lastSendTime = now;
+    }
   }
-  delay(400);
-}
\ No newline at end of file
+
+  reportSendRate(now);
+}